@@ -24,8 +24,12 @@
 #include <string.h>
 #include <assert.h>
 #include <pthread.h>
+#include <inttypes.h>
+#include <time.h>
+#include <sys/time.h> /* gettimeofday() */
 
 #include "default_engine.h"
+#include "item_base.h"
 
 #define hashsize(n) ((uint32_t)1<<(n))
 #define hashmask(n) (hashsize(n)-1)
@@ -33,29 +37,212 @@
 #define GET_HASH_BUCKET(hash, mask)        ((hash) & (mask))
 #define GET_HASH_TABIDX(hash, shift, mask) (((hash) >> (shift)) & (mask))
 
+/* The hash table is expanded if the average number of items in a bucket
+ * exceeds it. Most items still fit in the bucket slots.
+ */
+#define ASSOC_BUCKET_LOAD 4
+
+/* The hash table is shrunk if the average number of items in a bucket
+ * stays below (ASSOC_BUCKET_LOAD / ASSOC_SHRINK_RATIO) for ASSOC_SHRINK_DELAY.
+ */
+#define ASSOC_SHRINK_RATIO 8
+#define ASSOC_SHRINK_DELAY 30 /* seconds */
+
 static struct assoc         *assocp=NULL; // engine assoc
+static struct engine_config *config=NULL; // engine config
 static EXTENSION_LOGGER_DESCRIPTOR *logger;
 
+/* hash table expansion thread */
+static pthread_mutex_t      exp_lock;
+static pthread_cond_t       exp_cond;
+static pthread_t            exp_tid; /* thread id */
+static bool                 exp_sleep = false;
+static volatile bool        exp_thread_stop = false;
+static volatile bool        exp_thread_running = false;
+
+/* The hash chains are traversed by lock-free readers.
+ * See item_get_lockfree(). So, the hash chain links are published with
+ * the release semantic after the linked item is initialized.
+ */
+#define CHAIN_LOAD(p)     __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define CHAIN_STORE(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+/* The expanding bucket is moved by the thread holding the cache lock of
+ * the bucket. So, the threads of other cache partitions can see it changed.
+ * exp_tabidx is reset before exp_bucket is moved to the next bucket.
+ */
+static inline uint32_t GET_EXP_BUCKET(void)
+{
+    return __atomic_load_n(&assocp->exp_bucket, __ATOMIC_ACQUIRE);
+}
+
+static inline void SET_EXP_BUCKET(uint32_t bucket)
+{
+    __atomic_store_n(&assocp->exp_bucket, bucket, __ATOMIC_RELEASE);
+}
+
+/* The shrinking bucket is moved like the expanding bucket.
+ * shr_tabidx is reset before shr_bucket is moved to the next bucket.
+ */
+static inline uint32_t GET_SHR_BUCKET(void)
+{
+    return __atomic_load_n(&assocp->shr_bucket, __ATOMIC_ACQUIRE);
+}
+
+static inline void SET_SHR_BUCKET(uint32_t bucket)
+{
+    __atomic_store_n(&assocp->shr_bucket, bucket, __ATOMIC_RELEASE);
+}
+
+/* While the hash table is being shrunk, the items of the upper half tables
+ * are moved into the lower half tables. Returns true if the given upper
+ * half table of the bucket has been moved.
+ */
+static inline bool SHRUNK_HASH_TABLE(uint32_t tabidx, uint32_t bucket, uint32_t half)
+{
+    uint32_t shr_bucket = GET_SHR_BUCKET();
+    /* Note that hash table buckets are shrunk in backward order */
+    return (bucket > shr_bucket ||
+            (bucket == shr_bucket && (tabidx - half) < assocp->shr_tabidx));
+}
+
+/* The lock-free readers might get a wrong table index while the hash table
+ * is being expanded or shrunk. It only makes them fail to find the item.
+ * The root table and the new hash tables are set before the root mask is
+ * changed, and the shrunk hash tables are freed after the readers are gone.
+ */
 static inline uint32_t CUR_HASH_TABIDX(uint32_t hash, uint32_t bucket)
 {
-    if (assocp->expanding) {
+    uint32_t rootmask = __atomic_load_n(&assocp->rootmask, __ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&assocp->shrinking, __ATOMIC_ACQUIRE)) {
+        uint32_t half = (rootmask + 1) / 2;
+        uint32_t tabidx = (hash >> assocp->hashpower) & rootmask;
+        if (tabidx >= half && SHRUNK_HASH_TABLE(tabidx, bucket, half)) {
+            return tabidx - half;
+        }
+        return tabidx;
+    }
+    if (__atomic_load_n(&assocp->expanding, __ATOMIC_ACQUIRE)) {
+        uint32_t exp_bucket = GET_EXP_BUCKET();
         /* Note that hash table buckets are expanded in backward order */
-        if (bucket < assocp->exp_bucket) { /* NOT yet expanded */
+        if (bucket < exp_bucket) { /* NOT yet expanded */
             return (hash >> assocp->hashpower) & assocp->prevmask;
         }
-        if (bucket > assocp->exp_bucket) { /* Already expanded */
-            return (hash >> assocp->hashpower) & assocp->rootmask;
+        if (bucket > exp_bucket) { /* Already expanded */
+            return (hash >> assocp->hashpower) & rootmask;
         }
         if (true) { /* (bucket == assocp->exp_bucket) */
             uint32_t tabidx;
             tabidx = (hash >> assocp->hashpower) & assocp->prevmask;
             if (tabidx < assocp->exp_tabidx) { /* Already expanded */
-                return (hash >> assocp->hashpower) & assocp->rootmask;
+                return (hash >> assocp->hashpower) & rootmask;
             }
             return tabidx;
         }
     } else {
-        return (hash >> assocp->hashpower) & assocp->rootmask;
+        return (hash >> assocp->hashpower) & rootmask;
+    }
+}
+
+static inline struct table *ROOT_TABLE(void)
+{
+    return __atomic_load_n(&assocp->roottable, __ATOMIC_ACQUIRE);
+}
+
+/*
+ * Hash bucket slots
+ *
+ * The slot tags are matched in a 64-bit word at once. The slots are
+ * changed only by the thread holding the cache lock of the bucket,
+ * and the slot item is set before its tag is published.
+ */
+#define TAG_ONES  0x0101010101010101ULL
+#define TAG_HIGHS 0x8080808080808080ULL
+
+static inline uint64_t HASH_TAG(uint32_t hash)
+{
+    /* The lower bits of the hash are the same in a bucket */
+    uint32_t tag = (hash ^ (hash >> 8) ^ (hash >> 16) ^ (hash >> 24)) & 0xFF;
+    return (tag != 0 ? tag : 1);
+}
+
+/* returns a mask having the high bit set in each matched tag byte.
+ * It might have false positives above a matched byte, so the slot item
+ * must be checked by the caller.
+ */
+static inline uint64_t TAG_MATCH(uint64_t tags, uint64_t tag)
+{
+    uint64_t x = tags ^ (tag * TAG_ONES);
+    return (x - TAG_ONES) & ~x & TAG_HIGHS;
+}
+
+static inline int TAG_MATCH_SLOT(uint64_t match)
+{
+    return __builtin_ctzll(match) >> 3;
+}
+
+static inline uint64_t GET_SLOT_TAG(uint64_t tags, int slot)
+{
+    return (tags >> (slot * 8)) & 0xFF;
+}
+
+static inline void SET_SLOT_TAG(struct assoc_bucket *b, int slot, uint64_t tag)
+{
+    uint64_t tags = b->tags & ~((uint64_t)0xFF << (slot * 8));
+    __atomic_store_n(&b->tags, tags | (tag << (slot * 8)), __ATOMIC_RELEASE);
+}
+
+static inline struct assoc_bucket *GET_BUCKET(uint32_t tabidx, uint32_t bucket)
+{
+    return &assocp->roottable[tabidx].hashtable[bucket];
+}
+
+static struct assoc_bucket *_hashtable_alloc(uint32_t count)
+{
+    void *table;
+    if (posix_memalign(&table, sizeof(struct assoc_bucket),
+                       sizeof(struct assoc_bucket) * count) != 0) {
+        return NULL;
+    }
+    memset(table, 0, sizeof(struct assoc_bucket) * count);
+    return table;
+}
+
+/* link the item into an empty slot or the overflow chain */
+static void _bucket_link(struct assoc_bucket *b, hash_item *it)
+{
+    for (int i = 0; i < ASSOC_BUCKET_SLOTS; i++) {
+        if (b->slots[i] == NULL) {
+            it->h_next = NULL;
+            CHAIN_STORE(b->slots[i], it);
+            SET_SLOT_TAG(b, i, HASH_TAG(it->khash));
+            return;
+        }
+    }
+    it->h_next = b->chain;
+    CHAIN_STORE(b->chain, it);
+}
+
+static void _bucket_unlink_slot(struct assoc_bucket *b, int slot)
+{
+    SET_SLOT_TAG(b, slot, 0);
+    CHAIN_STORE(b->slots[slot], NULL);
+}
+
+/* move the overflow chain items into the empty slots.
+ * It must not be called while the bucket is being scanned.
+ */
+static void _bucket_compact(struct assoc_bucket *b)
+{
+    hash_item *it;
+    for (int i = 0; i < ASSOC_BUCKET_SLOTS && b->chain != NULL; i++) {
+        if (b->slots[i] == NULL) {
+            it = b->chain;
+            CHAIN_STORE(b->slots[i], it);
+            SET_SLOT_TAG(b, i, HASH_TAG(it->khash));
+            CHAIN_STORE(b->chain, it->h_next);
+            CHAIN_STORE(it->h_next, NULL);
+        }
     }
 }
 
@@ -63,6 +250,7 @@ ENGINE_ERROR_CODE assoc_init(struct default_engine *engine)
 {
     /* initialize global variables */
     assocp = &engine->assoc;
+    config = &engine->config;
     logger = engine->server.log->get_logger();
 
     assocp->hashpower = 16; /* (1<<16) => 64K hash size */
@@ -72,15 +260,19 @@ ENGINE_ERROR_CODE assoc_init(struct default_engine *engine)
     assocp->rootsize = hashsize(assocp->rootpower);
     assocp->rootmask = hashmask(assocp->rootpower);
     assocp->roottabsz = 512;
-    /* expansion status */
+    /* expansion and shrink status */
     assocp->expanding = false;
+    assocp->shrinking = false;
 
     assocp->roottable = NULL;
     assocp->infotable = NULL;
 
     /* hash items and expansion limit */
     assocp->hash_items = 0;
-    assocp->hash_expansion_limit = (assocp->hashsize * assocp->rootsize * 3) / 2;
+    assocp->hash_expansion_limit = assocp->hashsize * assocp->rootsize * ASSOC_BUCKET_LOAD;
+    memset(&assocp->exp_stats, 0, sizeof(struct assoc_exp_stats));
+    pthread_mutex_init(&exp_lock, NULL);
+    pthread_cond_init(&exp_cond, NULL);
 
     assocp->infotable = calloc(assocp->hashsize, sizeof(struct bucket_info));
     if (assocp->infotable == NULL) {
@@ -91,7 +283,7 @@ ENGINE_ERROR_CODE assoc_init(struct default_engine *engine)
         free(assocp->infotable);
         return ENGINE_ENOMEM;
     }
-    assocp->roottable[0].hashtable = calloc(assocp->hashsize, sizeof(void*));
+    assocp->roottable[0].hashtable = _hashtable_alloc(assocp->hashsize);
     if (assocp->roottable[0].hashtable == NULL) {
         free(assocp->infotable);
         free(assocp->roottable);
@@ -120,47 +312,57 @@ void assoc_final(struct default_engine *engine)
     if (assocp->infotable) {
         free(assocp->infotable);
     }
+    pthread_mutex_destroy(&exp_lock);
+    pthread_cond_destroy(&exp_cond);
     logger->log(EXTENSION_LOG_INFO, NULL, "ASSOC module destroyed.\n");
 }
 
-static void redistribute(void)
+/* redistribute the items of the expanding bucket in a hash table.
+ * Returns true if the expanding bucket has been moved to the next one.
+ */
+static bool redistribute(void)
 {
+    struct assoc_bucket *b;
     hash_item **prev;
     hash_item *it;
     uint32_t tabidx;
 
-    /* How many buckets should redistribute at a time?
-     * If it is too few, it will longer hashtable expansion and decrease average throughput.
-     * If it is too many, it will shorten hashtable expansion but it can result a throughput drop.
-     */
-    for (uint32_t rdbcnt = 0; rdbcnt < 4; rdbcnt++) {
-        prev = &assocp->roottable[assocp->exp_tabidx].hashtable[assocp->exp_bucket];
-        while ((it = *prev) != NULL) {
-            tabidx = (it->khash >> assocp->hashpower) & assocp->rootmask;
-            //tabidx = GET_HASH_TABIDX(it->khash, assocp->hashpower, assocp->rootmask);
-            if (tabidx == assocp->exp_tabidx) {
-                prev = &it->h_next;
-            } else {
-                *prev = it->h_next;
-                it->h_next = assocp->roottable[tabidx].hashtable[assocp->exp_bucket];
-                assocp->roottable[tabidx].hashtable[assocp->exp_bucket] = it;
-            }
+    b = GET_BUCKET(assocp->exp_tabidx, assocp->exp_bucket);
+    for (int i = 0; i < ASSOC_BUCKET_SLOTS; i++) {
+        if ((it = b->slots[i]) == NULL) continue;
+        tabidx = (it->khash >> assocp->hashpower) & assocp->rootmask;
+        if (tabidx != assocp->exp_tabidx) {
+            _bucket_unlink_slot(b, i);
+            _bucket_link(GET_BUCKET(tabidx, assocp->exp_bucket), it);
         }
-        assocp->exp_tabidx += 1;
-        if (assocp->exp_tabidx >= assocp->prevsize) break;
     }
-
-    if (assocp->exp_tabidx >= assocp->prevsize) {
-        assocp->exp_tabidx = 0;
-        /* set the next bucket in backward */
-        if (assocp->exp_bucket > 0) {
-            assocp->exp_bucket -= 1;
+    prev = &b->chain;
+    while ((it = *prev) != NULL) {
+        tabidx = (it->khash >> assocp->hashpower) & assocp->rootmask;
+        //tabidx = GET_HASH_TABIDX(it->khash, assocp->hashpower, assocp->rootmask);
+        if (tabidx == assocp->exp_tabidx) {
+            prev = &it->h_next;
         } else {
-            /* No bucket to expand. Stop expansion */
-            assocp->expanding = false;
-            logger->log(EXTENSION_LOG_INFO, NULL, "hash table expansion completed.\n");
+            CHAIN_STORE(*prev, it->h_next);
+            _bucket_link(GET_BUCKET(tabidx, assocp->exp_bucket), it);
         }
     }
+    _bucket_compact(b);
+
+    assocp->exp_tabidx += 1;
+    if (assocp->exp_tabidx < assocp->prevsize) {
+        return false;
+    }
+    assocp->exp_tabidx = 0;
+    /* set the next bucket in backward */
+    if (assocp->exp_bucket > 0) {
+        SET_EXP_BUCKET(assocp->exp_bucket - 1);
+    } else {
+        /* No bucket to expand. Stop expansion */
+        __atomic_store_n(&assocp->expanding, false, __ATOMIC_RELEASE);
+        logger->log(EXTENSION_LOG_INFO, NULL, "hash table expansion completed.\n");
+    }
+    return true;
 }
 
 hash_item *assoc_find(const char *key, const uint32_t nkey, uint32_t hash)
@@ -171,31 +373,67 @@ hash_item *assoc_find(const char *key, const uint32_t nkey, uint32_t hash)
 #endif
     uint32_t bucket = GET_HASH_BUCKET(hash, assocp->hashmask);
     uint32_t tabidx = CUR_HASH_TABIDX(hash, bucket);
+    struct assoc_bucket *b = &ROOT_TABLE()[tabidx].hashtable[bucket];
+    uint64_t match = TAG_MATCH(__atomic_load_n(&b->tags, __ATOMIC_ACQUIRE), HASH_TAG(hash));
 
-    it = assocp->roottable[tabidx].hashtable[bucket];
+    while (match != 0) {
+        int slot = TAG_MATCH_SLOT(match);
+        if (slot < ASSOC_BUCKET_SLOTS) {
+            it = CHAIN_LOAD(b->slots[slot]);
+            if (it && (hash == it->khash) && (nkey == it->nkey) &&
+                (memcmp(key, item_get_key(it), nkey) == 0)) {
+                goto done; /* found */
+            }
+#ifdef ENABLE_DTRACE
+            ++depth;
+#endif
+        }
+        match &= (match - 1);
+    }
+
+    it = CHAIN_LOAD(b->chain);
     while (it) {
         if ((hash == it->khash) && (nkey == it->nkey) &&
             (memcmp(key, item_get_key(it), nkey) == 0)) {
             break; /* found */
         }
-        it = it->h_next;
+        it = CHAIN_LOAD(it->h_next);
 #ifdef ENABLE_DTRACE
         ++depth;
 #endif
     }
+done:
     MEMCACHED_ASSOC_FIND(key, nkey, depth);
     return it;
 }
 
-/* returns the address of the item pointer before the key.  if *item == 0,
-   the item wasn't found */
-static hash_item** _hashitem_before(const char *key, const uint32_t nkey, uint32_t hash)
+/* returns the address of the item pointer of the key in the bucket slots
+   or the overflow chain. if *item == 0, the item wasn't found.
+   *slot is set to the slot index, or -1 if it's in the overflow chain. */
+static hash_item** _hashitem_before(const char *key, const uint32_t nkey, uint32_t hash,
+                                    struct assoc_bucket **bp, int *slot)
 {
     hash_item **pos;
     uint32_t bucket = GET_HASH_BUCKET(hash, assocp->hashmask);
     uint32_t tabidx = CUR_HASH_TABIDX(hash, bucket);
+    struct assoc_bucket *b = GET_BUCKET(tabidx, bucket);
+    uint64_t match = TAG_MATCH(b->tags, HASH_TAG(hash));
+
+    *bp = b;
+    while (match != 0) {
+        int i = TAG_MATCH_SLOT(match);
+        if (i < ASSOC_BUCKET_SLOTS) {
+            pos = &b->slots[i];
+            if (*pos && nkey == (*pos)->nkey && memcmp(key, item_get_key(*pos), nkey) == 0) {
+                *slot = i;
+                return pos;
+            }
+        }
+        match &= (match - 1);
+    }
 
-    pos = &assocp->roottable[tabidx].hashtable[bucket];
+    *slot = -1;
+    pos = &b->chain;
     while (*pos && ((nkey != (*pos)->nkey) || memcmp(key, item_get_key(*pos), nkey))) {
         pos = &(*pos)->h_next;
     }
@@ -204,32 +442,75 @@ static hash_item** _hashitem_before(const char *key, const uint32_t nkey, uint32
 
 static int assoc_expand_roottable(uint32_t new_roottabsz)
 {
+    struct table *old_roottable = assocp->roottable;
     struct table *new_roottable;
 
-    new_roottable = realloc(assocp->roottable, sizeof(void*) * new_roottabsz);
+    /* The old root table might be used by lock-free readers.
+     * So, it's freed after they are gone instead of realloc().
+     */
+    new_roottable = malloc(sizeof(void*) * new_roottabsz);
     if (new_roottable == NULL) {
         return -1;
     }
-    assocp->roottable = new_roottable;
+    memcpy(new_roottable, old_roottable, sizeof(void*) * assocp->roottabsz);
+    __atomic_store_n(&assocp->roottable, new_roottable, __ATOMIC_RELEASE);
     assocp->roottabsz = new_roottabsz;
+    item_read_synchronize();
+    free(old_roottable);
     return 0;
 }
 
-/* grows the hashtable to the next power of 2. */
+static inline uint64_t get_usec_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void assoc_exp_stats_hold(uint64_t hold)
+{
+    struct assoc_exp_stats *stats = &assocp->exp_stats;
+
+    pthread_mutex_lock(&exp_lock);
+    stats->steps += 1;
+    if (stats->hold_max < hold) {
+        stats->hold_max = hold;
+    }
+    stats->hold_hist[hold < ASSOC_HOLD_HIST_SIZE ? hold : ASSOC_HOLD_HIST_SIZE] += 1;
+    pthread_mutex_unlock(&exp_lock);
+}
+
+static bool assoc_expand_needed(void)
+{
+    return (!assocp->expanding && !assocp->shrinking &&
+            assocp->hash_expansion_limit != 0 &&
+            assocp->hash_items > assocp->hash_expansion_limit);
+}
+
+/* grows the hashtable to the next power of 2.
+ * The new hash tables are allocated without the cache locks,
+ * and they are published while holding all the cache locks.
+ * Only the expansion thread changes the hash table sizes.
+ */
 static void assoc_expand(void)
 {
-    hash_item** new_hashtable;
+    struct assoc_bucket *new_hashtable;
+    uint64_t start;
 
+    new_hashtable = _hashtable_alloc(assocp->hashsize * assocp->rootsize);
+    if (new_hashtable == NULL) {
+        return;
+    }
+
+    LOCK_CACHE_ALL();
+    start = get_usec_time();
     if (assocp->roottabsz < (assocp->rootsize * 2)) {
         if (assoc_expand_roottable(assocp->roottabsz * 2) < 0) {
+            UNLOCK_CACHE();
+            free(new_hashtable);
             return;
         }
     }
-
-    new_hashtable = calloc(assocp->hashsize * assocp->rootsize, sizeof(void *));
-    if (new_hashtable == NULL) {
-        return;
-    }
     for (int ii=0; ii < assocp->rootsize; ++ii) {
         assocp->roottable[assocp->rootsize+ii].hashtable = &new_hashtable[assocp->hashsize*ii];
     }
@@ -237,24 +518,118 @@ static void assoc_expand(void)
     assocp->prevsize = assocp->rootsize;
     assocp->prevmask = assocp->rootmask;
     assocp->rootsize = hashsize(assocp->rootpower);
-    assocp->rootmask = hashmask(assocp->rootpower);
+    __atomic_store_n(&assocp->rootmask, hashmask(assocp->rootpower), __ATOMIC_RELEASE);
 
     /* set hash_expansion_limit */
     if (assocp->rootpower < 15) {
-        assocp->hash_expansion_limit = (assocp->hashsize * assocp->rootsize * 3) / 2;
+        assocp->hash_expansion_limit = assocp->hashsize * assocp->rootsize * ASSOC_BUCKET_LOAD;
     } else { /* assocp->rootpower >= 15 */
         assocp->hash_expansion_limit = 0; /* do not allow hash expansion any more */
     }
 
     /* set hash table expansion */
-    assocp->expanding = true;
-    assocp->exp_bucket = assocp->hashsize - 1;
     assocp->exp_tabidx = 0;
+    SET_EXP_BUCKET(assocp->hashsize - 1);
+    __atomic_store_n(&assocp->expanding, true, __ATOMIC_RELEASE);
+    UNLOCK_CACHE();
+    assoc_exp_stats_hold(get_usec_time() - start);
 
     logger->log(EXTENSION_LOG_INFO, NULL, "hash table expansion started(size: %u -> %u).\n",
             assocp->hashsize * assocp->rootsize / 2, assocp->hashsize * assocp->rootsize);
 }
 
+/* move the items of the shrinking bucket in an upper half table
+ * into the lower half table.
+ * Returns true if the shrinking bucket has been moved to the next one.
+ */
+static bool shrink_bucket(void)
+{
+    uint32_t half = assocp->rootsize / 2;
+    struct assoc_bucket *src = GET_BUCKET(half + assocp->shr_tabidx, assocp->shr_bucket);
+    struct assoc_bucket *dst = GET_BUCKET(assocp->shr_tabidx, assocp->shr_bucket);
+    hash_item *it;
+
+    for (int i = 0; i < ASSOC_BUCKET_SLOTS; i++) {
+        if ((it = src->slots[i]) != NULL) {
+            _bucket_unlink_slot(src, i);
+            _bucket_link(dst, it);
+        }
+    }
+    while ((it = src->chain) != NULL) {
+        CHAIN_STORE(src->chain, it->h_next);
+        _bucket_link(dst, it);
+    }
+
+    if (assocp->shr_tabidx + 1 < half) {
+        assocp->shr_tabidx += 1;
+        return false;
+    }
+    /* set the next bucket in backward */
+    if (assocp->shr_bucket > 0) {
+        assocp->shr_tabidx = 0;
+        SET_SHR_BUCKET(assocp->shr_bucket - 1);
+    } else {
+        /* All the buckets are shrunk. See assoc_shrink_done(). */
+        assocp->shr_tabidx = half;
+    }
+    return true;
+}
+
+static bool assoc_shrink_needed(void)
+{
+    return (!assocp->expanding && !assocp->shrinking && assocp->rootpower > 0 &&
+            assocp->hash_items < ((uint64_t)assocp->hashsize * assocp->rootsize *
+                                  ASSOC_BUCKET_LOAD / ASSOC_SHRINK_RATIO));
+}
+
+/* shrinks the hashtable to the previous power of 2.
+ * The items of the upper half tables are moved by shrink_bucket(),
+ * and then the upper half tables are freed by assoc_shrink_done().
+ */
+static void assoc_shrink(void)
+{
+    uint64_t start;
+
+    LOCK_CACHE_ALL();
+    start = get_usec_time();
+    assocp->shr_tabidx = 0;
+    SET_SHR_BUCKET(assocp->hashsize - 1);
+    __atomic_store_n(&assocp->shrinking, true, __ATOMIC_RELEASE);
+    UNLOCK_CACHE();
+    assoc_exp_stats_hold(get_usec_time() - start);
+
+    logger->log(EXTENSION_LOG_INFO, NULL, "hash table shrink started(size: %u -> %u).\n",
+            assocp->hashsize * assocp->rootsize, assocp->hashsize * assocp->rootsize / 2);
+}
+
+static void assoc_shrink_done(void)
+{
+    struct assoc_bucket *old_hashtable;
+    uint32_t half = assocp->rootsize / 2;
+    uint64_t start;
+
+    LOCK_CACHE_ALL();
+    start = get_usec_time();
+    /* The upper half tables are allocated at once. See assoc_expand(). */
+    old_hashtable = assocp->roottable[half].hashtable;
+    assocp->rootpower -= 1;
+    assocp->rootsize = half;
+    __atomic_store_n(&assocp->rootmask, hashmask(assocp->rootpower), __ATOMIC_RELEASE);
+    __atomic_store_n(&assocp->shrinking, false, __ATOMIC_RELEASE);
+    assocp->hash_expansion_limit = assocp->hashsize * assocp->rootsize * ASSOC_BUCKET_LOAD;
+    UNLOCK_CACHE();
+    assoc_exp_stats_hold(get_usec_time() - start);
+
+    /* lock-free readers might be on the upper half tables */
+    item_read_synchronize();
+    for (int ii=0; ii < half; ++ii) {
+        assocp->roottable[half+ii].hashtable = NULL;
+    }
+    free(old_hashtable);
+
+    logger->log(EXTENSION_LOG_INFO, NULL, "hash table shrink completed.\n");
+}
+
 /* Note: this isn't an assoc_update.  The key must not already exist to call this */
 int assoc_insert(hash_item *it, uint32_t hash)
 {
@@ -265,20 +640,15 @@ int assoc_insert(hash_item *it, uint32_t hash)
     assert(assoc_find(item_get_key(it), it->nkey, hash) == 0);
 
     /* inserting actual hash_item to appropriate assoc_t */
-    it->h_next = assocp->roottable[tabidx].hashtable[bucket];
-    assocp->roottable[tabidx].hashtable[bucket] = it;
+    _bucket_link(GET_BUCKET(tabidx, bucket), it);
 
-    assocp->hash_items++;
+    (void)__sync_add_and_fetch(&assocp->hash_items, 1);
 
-    if (assocp->expanding) {
-        if (assocp->infotable[assocp->exp_bucket].refcount == 0) {
-            redistribute();
-        }
-    } else {
-        if (assocp->hash_expansion_limit != 0 &&
-            assocp->hash_items > assocp->hash_expansion_limit) {
-            assoc_expand();
-        }
+    /* The hash table is expanded by the expansion thread */
+    if (assoc_expand_needed() && exp_sleep) {
+        pthread_mutex_lock(&exp_lock);
+        pthread_cond_signal(&exp_cond);
+        pthread_mutex_unlock(&exp_lock);
     }
 
     MEMCACHED_ASSOC_INSERT(item_get_key(it), it->nkey, assocp->hash_items);
@@ -287,34 +657,49 @@ int assoc_insert(hash_item *it, uint32_t hash)
 
 void assoc_replace(hash_item *old_it, hash_item *new_it)
 {
-    hash_item **before = _hashitem_before(item_get_key(old_it), old_it->nkey, old_it->khash);
+    struct assoc_bucket *b;
+    int slot;
+    hash_item **before = _hashitem_before(item_get_key(old_it), old_it->nkey, old_it->khash,
+                                          &b, &slot);
 
     /* The DTrace probe cannot be triggered as the last instruction
      * due to possible tail-optimization by the compiler
      */
     MEMCACHED_ASSOC_DELETE(key, old_it->nkey, assocp->hash_items);
+    /* The slot tag is not changed since both items have the same key */
     new_it->h_next = old_it->h_next;
-    *before = new_it;
-    (old_it)->h_next = NULL;
+    CHAIN_STORE(*before, new_it);
+    CHAIN_STORE(old_it->h_next, NULL);
 
     MEMCACHED_ASSOC_INSERT(item_get_key(new_it), new_it->nkey, assocp->hash_items);
 }
 
 void assoc_delete(const char *key, const uint32_t nkey, uint32_t hash)
 {
-    hash_item **before = _hashitem_before(key, nkey, hash);
+    struct assoc_bucket *b;
+    int slot;
+    hash_item **before = _hashitem_before(key, nkey, hash, &b, &slot);
 
     if (*before) {
         hash_item *nxt;
-        assocp->hash_items--;
+        (void)__sync_sub_and_fetch(&assocp->hash_items, 1);
 
        /* The DTrace probe cannot be triggered as the last instruction
          * due to possible tail-optimization by the compiler
          */
         MEMCACHED_ASSOC_DELETE(key, nkey, assocp->hash_items);
+        if (slot >= 0) {
+            _bucket_unlink_slot(b, slot);
+            /* The scan on the bucket relies on the item positions */
+            if (b->chain != NULL &&
+                assocp->infotable[GET_HASH_BUCKET(hash, assocp->hashmask)].refcount == 0) {
+                _bucket_compact(b);
+            }
+            return;
+        }
         nxt = (*before)->h_next;
-        (*before)->h_next = 0;   /* probably pointless, but whatever. */
-        *before = nxt;
+        CHAIN_STORE((*before)->h_next, NULL); /* probably pointless, but whatever. */
+        CHAIN_STORE(*before, nxt);
 
         return;
     }
@@ -323,8 +708,182 @@ void assoc_delete(const char *key, const uint32_t nkey, uint32_t hash)
     assert(*before != 0);
 }
 
+/*
+ * Hash table expansion thread
+ *
+ * The expanding(or shrinking) buckets are moved in small steps. Each step
+ * holds the cache lock of the bucket within the configured time budget.
+ */
+
+/* Move the given bucket within the step budget.
+ * Returns false if the bucket is being scanned.
+ */
+static bool assoc_resize_step(uint32_t bucket, bool (*move_bucket)(void))
+{
+    uint64_t budget = config->hash_expand_step_usec;
+    uint64_t start, hold;
+    bool moved;
+
+    LOCK_CACHE(bucket);
+    start = get_usec_time();
+    if (assocp->infotable[bucket].refcount > 0) {
+        UNLOCK_CACHE();
+        return false;
+    }
+    /* stop at the end of the bucket since the next bucket
+     * belongs to another cache partition.
+     */
+    do {
+        moved = move_bucket();
+        hold = get_usec_time() - start;
+    } while (!moved && hold < budget);
+    UNLOCK_CACHE();
+
+    assoc_exp_stats_hold(hold);
+    return true;
+}
+
+static void assoc_thread_sleep(uint32_t msec)
+{
+    struct timeval  tv;
+    struct timespec to;
+    pthread_mutex_lock(&exp_lock);
+    if (!exp_thread_stop) {
+        gettimeofday(&tv, NULL);
+        tv.tv_usec += msec * 1000;
+        tv.tv_sec += tv.tv_usec / 1000000;
+        tv.tv_usec %= 1000000;
+        to.tv_sec = tv.tv_sec;
+        to.tv_nsec = tv.tv_usec * 1000;
+
+        exp_sleep = true;
+        pthread_cond_timedwait(&exp_cond, &exp_lock, &to);
+        exp_sleep = false;
+    }
+    pthread_mutex_unlock(&exp_lock);
+}
+
+static void *assoc_expand_thread(void *arg)
+{
+    uint64_t shrink_since = 0; /* the time the shrink is needed from */
+
+    exp_thread_running = true;
+
+    while (!exp_thread_stop) {
+        if (assocp->expanding) {
+            if (!assoc_resize_step(GET_EXP_BUCKET(), redistribute)) {
+                /* wait for the scan on the bucket */
+                assoc_thread_sleep(1);
+            }
+            continue;
+        }
+        if (assocp->shrinking) {
+            if (GET_SHR_BUCKET() == 0 && assocp->shr_tabidx == assocp->rootsize / 2) {
+                assoc_shrink_done();
+            } else if (!assoc_resize_step(GET_SHR_BUCKET(), shrink_bucket)) {
+                /* wait for the scan on the bucket */
+                assoc_thread_sleep(1);
+            }
+            continue;
+        }
+        if (assoc_expand_needed()) {
+            assoc_expand();
+            if (assocp->expanding) {
+                pthread_mutex_lock(&exp_lock);
+                assocp->exp_stats.expansions += 1;
+                pthread_mutex_unlock(&exp_lock);
+                continue;
+            }
+        }
+        if (assoc_shrink_needed()) {
+            uint64_t now = get_usec_time();
+            if (shrink_since == 0) {
+                shrink_since = now;
+            } else if (now - shrink_since >= ASSOC_SHRINK_DELAY * 1000000ULL) {
+                shrink_since = 0;
+                assoc_shrink();
+                pthread_mutex_lock(&exp_lock);
+                assocp->exp_stats.shrinks += 1;
+                pthread_mutex_unlock(&exp_lock);
+                continue;
+            }
+        } else {
+            shrink_since = 0;
+        }
+        assoc_thread_sleep(1000);
+    }
+
+    exp_thread_running = false;
+    return NULL;
+}
+
+int assoc_thread_start(void)
+{
+    exp_thread_stop = false;
+    int ret = pthread_create(&exp_tid, NULL, assoc_expand_thread, NULL);
+    if (ret != 0) {
+        logger->log(EXTENSION_LOG_WARNING, NULL,
+                    "Can't create assoc thread: %s\n", strerror(ret));
+        return -1;
+    }
+    return 0;
+}
+
+void assoc_thread_stop(void)
+{
+    pthread_mutex_lock(&exp_lock);
+    exp_thread_stop = true;
+    pthread_cond_signal(&exp_cond);
+    pthread_mutex_unlock(&exp_lock);
+    pthread_join(exp_tid, NULL);
+}
+
+void assoc_stats(ADD_STAT add_stat, const void *cookie)
+{
+    struct assoc_exp_stats *stats = &assocp->exp_stats;
+    char val[128];
+    int len;
+    uint64_t p99 = 0;
+    uint64_t sum = 0;
+
+    pthread_mutex_lock(&exp_lock);
+    for (int i = 0; i <= ASSOC_HOLD_HIST_SIZE; i++) {
+        sum += stats->hold_hist[i];
+        if (sum * 100 >= stats->steps * 99) {
+            p99 = (i < ASSOC_HOLD_HIST_SIZE ? i : stats->hold_max);
+            break;
+        }
+    }
+    len = sprintf(val, "%"PRIu64, (uint64_t)assocp->hashsize * assocp->rootsize);
+    add_stat("hash_table_size", 15, val, len, cookie);
+    len = sprintf(val, "%"PRIu64, assocp->hash_items);
+    add_stat("hash_items", 10, val, len, cookie);
+    len = sprintf(val, "%d", assocp->expanding ? 1 : 0);
+    add_stat("hash_expanding", 14, val, len, cookie);
+    len = sprintf(val, "%"PRIu64, stats->expansions);
+    add_stat("hash_expansions", 15, val, len, cookie);
+    len = sprintf(val, "%d", assocp->shrinking ? 1 : 0);
+    add_stat("hash_shrinking", 14, val, len, cookie);
+    len = sprintf(val, "%"PRIu64, stats->shrinks);
+    add_stat("hash_shrinks", 12, val, len, cookie);
+    len = sprintf(val, "%u", config->hash_expand_step_usec);
+    add_stat("expand_step_usec", 16, val, len, cookie);
+    len = sprintf(val, "%"PRIu64, stats->steps);
+    add_stat("expand_steps", 12, val, len, cookie);
+    len = sprintf(val, "%"PRIu64, stats->hold_max);
+    add_stat("expand_hold_max_usec", 20, val, len, cookie);
+    len = sprintf(val, "%"PRIu64, p99);
+    add_stat("expand_hold_p99_usec", 20, val, len, cookie);
+    pthread_mutex_unlock(&exp_lock);
+}
+
 /*
  * Assoc scan functions
+ *
+ * The scan visits the bucket slots in order and then the overflow chain.
+ * The position in the overflow chain is kept by the placeholder item.
+ * While a bucket is being scanned, its items are not moved between
+ * the slots and the overflow chain.
  */
 static void _init_scan_placeholder(struct assoc_scan *scan)
 {
@@ -342,18 +901,18 @@ static void _link_scan_placeholder(struct assoc_scan *scan, hash_item *item)
 {
     /* link the placeholder item behind the given item */
     scan->ph_item.h_next = item->h_next;
-    item->h_next = &scan->ph_item;
+    CHAIN_STORE(item->h_next, &scan->ph_item);
     scan->ph_linked = true;
 }
 
 static hash_item *_unlink_scan_placeholder(struct assoc_scan *scan)
 {
     /* unlink the placeholder item and return the next item */
-    hash_item **p = &assocp->roottable[scan->tabidx].hashtable[scan->bucket];
+    hash_item **p = &GET_BUCKET(scan->tabidx, scan->bucket)->chain;
     assert(*p != NULL);
     while (*p != &scan->ph_item)
         p = &((*p)->h_next);
-    *p = (*p)->h_next;
+    CHAIN_STORE(*p, (*p)->h_next);
     scan->ph_linked = false;
     return *p;
 }
@@ -366,6 +925,7 @@ void assoc_scan_init(struct assoc_scan *scan)
     scan->tabcnt = 0; /* 0 means the scan on the current
                        * bucket chain has not yet started.
                        */
+    scan->slotidx = 0;
     _init_scan_placeholder(scan);
     scan->initialized = true;
 }
@@ -374,6 +934,7 @@ int assoc_scan_next(struct assoc_scan *scan, hash_item **item_array,
                     int array_size, int elem_limit)
 {
     assert(scan->initialized && array_size > 0);
+    struct assoc_bucket *b;
     hash_item *next;
     coll_meta_info *info;
     int item_count = 0;
@@ -387,22 +948,56 @@ int assoc_scan_next(struct assoc_scan *scan, hash_item **item_array,
             /* start the scan on the current bucket */
             scan->tabcnt = assocp->rootsize;
             scan->tabidx = 0;
+            scan->slotidx = 0;
             assert(scan->tabcnt > 0);
             /* increment bucket's reference count */
             assocp->infotable[scan->bucket].refcount += 1;
         }
 
+        if (scan->tabcnt > assocp->rootsize) {
+            /* The hash table has been shrunk. The upper half tables of
+             * the bucket were moved into the lower half before the scan
+             * started on the bucket since the bucket cannot be shrunk
+             * while it's being scanned.
+             */
+            scan->tabcnt = assocp->rootsize;
+        }
         while (scan->tabidx < scan->tabcnt) {
             if (scan_cost > (2*array_size) && item_count > 0) {
                 /* too large scan cost, stop the scan */
                 scan_done = true;  break;
             }
+            b = GET_BUCKET(scan->tabidx, scan->bucket);
+            scan_cost++;
+            /* scan the bucket slots */
+            while (scan->slotidx < ASSOC_BUCKET_SLOTS) {
+                next = b->slots[scan->slotidx++];
+                if (next == NULL) {
+                    continue;
+                }
+                item_array[item_count++] = next; /* user cache item */
+                scan_cost++;
+                if (item_count >= array_size) {
+                    scan_done = true;  break;
+                }
+                if (elem_limit > 0 && IS_COLL_ITEM(next)) {
+                    info = (coll_meta_info *)item_get_meta(next);
+                    elem_count += info->ccnt;
+                    if (elem_count > elem_limit) {
+                        scan_done = true;  break;
+                    }
+                }
+            }
+            if (scan_done) {
+                /* the array is full of items. stop the scan. */
+                break;
+            }
+            /* scan the overflow chain */
             if (scan->ph_linked) {
                 next = _unlink_scan_placeholder(scan);
             } else {
-                next = assocp->roottable[scan->tabidx].hashtable[scan->bucket];
+                next = b->chain;
             }
-            scan_cost++;
             while (next != NULL) {
                 if (next->nkey > 0) { /* Not placeholder item */
                     item_array[item_count++] = next; /* user cache item */
@@ -424,11 +1019,13 @@ int assoc_scan_next(struct assoc_scan *scan, hash_item **item_array,
                     _link_scan_placeholder(scan, next);
                 } else {
                     scan->tabidx += 1;
+                    scan->slotidx = 0;
                 }
                 /* the array is full of items. stop the scan. */
                 scan_done = true;  break;
             }
             scan->tabidx += 1;
+            scan->slotidx = 0;
         }
         if (scan_done) break;
 
@@ -484,13 +1081,24 @@ int assoc_scan_direct(const char *cursor, int req_count, hash_item **item_array,
     if (decode_cursor(cursor, &tabidx, &bucket) < 0) {
         return -1; /* invalid cursor */
     }
-    if (tabidx >= assocp->rootsize) {
-        return -1; /* invalid tabidx */
-    }
     if (bucket >= assocp->hashsize) {
         encode_cursor(cursor, 0, 0); /* scan end */
         return 0;
     }
+    /* The hash table might be shrunk after the cursor was given.
+     * The items of an upper half table are moved into the lower half table
+     * visited just before it. So, the lower half table is visited again.
+     * It might return the visited items again, but never misses items.
+     */
+    if (tabidx >= assocp->rootsize) {
+        tabidx &= assocp->rootmask;
+    }
+    if (assocp->shrinking) {
+        uint32_t half = assocp->rootsize / 2;
+        if (tabidx >= half && SHRUNK_HASH_TABLE(tabidx, bucket, half)) {
+            tabidx -= half;
+        }
+    }
 
     int item_count = 0;
     int hash_count = 0;
@@ -498,7 +1106,13 @@ int assoc_scan_direct(const char *cursor, int req_count, hash_item **item_array,
     while ((item_count < req_count && hash_count < hash_limit) ||
            (assocp->expanding && tabidx > assocp->prevmask))
     {
-        hash_item *next = assocp->roottable[tabidx].hashtable[bucket];
+        struct assoc_bucket *b = GET_BUCKET(tabidx, bucket);
+        for (int i = 0; i < ASSOC_BUCKET_SLOTS && item_count < array_size; i++) {
+            if (b->slots[i] != NULL) {
+                item_array[item_count++] = b->slots[i]; /* user cache item */
+            }
+        }
+        hash_item *next = (item_count < array_size ? b->chain : NULL);
         while (next != NULL) {
             if (next->nkey > 0) { /* Not placeholder item */
                 item_array[item_count++] = next; /* user cache item */
@@ -555,7 +1169,7 @@ bool assoc_scan_in_visited_area(struct assoc_scan *scan, hash_item *it)
     /* The given item is in the visited area if
      * (1) it's bucket < scan's bucket
      * (2) it's bucker == scan's bucket, but it's tabidx < scan's tabidx
-     * (3) or, it comes before the scan
+     * (3) or, it comes before the scan in the bucket slots or the overflow chain
      */
     if (bucket < scan->bucket) {
         return true;
@@ -566,7 +1180,13 @@ bool assoc_scan_in_visited_area(struct assoc_scan *scan, hash_item *it)
             return true;
         }
         if (tabidx == scan->tabidx) {
-            hash_item *p = assocp->roottable[tabidx].hashtable[scan->bucket];
+            struct assoc_bucket *b = GET_BUCKET(tabidx, scan->bucket);
+            for (int i = 0; i < ASSOC_BUCKET_SLOTS; i++) {
+                if (b->slots[i] == it) {
+                    return (i < scan->slotidx);
+                }
+            }
+            hash_item *p = b->chain;
             if (scan->ph_linked) {
                 while (p != &scan->ph_item) {
                     if (p == it) { /* We hit it before scan */
@@ -587,6 +1207,8 @@ void assoc_scan_final(struct assoc_scan *scan)
 
     if (scan->ph_linked) {
         (void)_unlink_scan_placeholder(scan);
+        /* lock-free readers might be on the placeholder item */
+        item_read_synchronize();
     }
     if (scan->bucket < scan->hashsz && scan->tabcnt > 0) {
         /* decrement bucket's reference count */
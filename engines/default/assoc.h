@@ -22,6 +22,37 @@ struct bucket_info {
     uint16_t refcount; /* reference count */
 };
 
+/* hash bucket : a cache line of item slots
+ *
+ * Each hash bucket keeps the first ASSOC_BUCKET_SLOTS items in its slots
+ * with the 8-bit tags taken from their key hash. So, assoc_find() matches
+ * the tags at once and usually touches only the bucket line before
+ * reaching the item. The other items are linked in the overflow hash chain.
+ */
+#define ASSOC_BUCKET_SLOTS 6
+
+struct assoc_bucket {
+    uint64_t   tags;  /* slot tags : 1 byte per slot, 0 means empty slot */
+    hash_item *slots[ASSOC_BUCKET_SLOTS];
+    hash_item *chain; /* overflow hash chain */
+} __attribute__((aligned(64)));
+
+/* hash table expansion(and shrink) step : lock hold time budget (usec) */
+#define MINIMUM_EXPAND_STEP_USEC 10
+#define MAXIMUM_EXPAND_STEP_USEC 10000
+#define DEFAULT_EXPAND_STEP_USEC 50
+
+/* lock hold time histogram of the expansion(and shrink) steps : 1 usec per slot */
+#define ASSOC_HOLD_HIST_SIZE 1024
+
+struct assoc_exp_stats {
+    uint64_t expansions; /* number of hash table expansions */
+    uint64_t shrinks;    /* number of hash table shrinks */
+    uint64_t steps;      /* number of expansion and shrink steps */
+    uint64_t hold_max;   /* max lock hold time of a step (usec) */
+    uint64_t hold_hist[ASSOC_HOLD_HIST_SIZE+1]; /* the last one is for overflow */
+};
+
 struct assoc {
     uint32_t hashpower; /* how many hash buckets in a hash table ? (power of 2) */
     uint32_t hashsize;  /* hash table size (constant value) */
@@ -38,9 +69,14 @@ struct assoc {
     uint32_t exp_bucket;
     uint32_t exp_tabidx;
 
+    /* hash table shrink status */
+    bool shrinking;
+    uint32_t shr_bucket;
+    uint32_t shr_tabidx; /* table index in the lower half */
+
     /* cache item hash table : an array of hash tables */
     struct table {
-       hash_item** hashtable;
+       struct assoc_bucket *hashtable;
     } *roottable;
 
     /* bucket info table */
@@ -48,6 +84,9 @@ struct assoc {
 
     uint64_t hash_items; /* number of items in all hash tables */
     uint64_t hash_expansion_limit;
+
+    /* hash table expansion stats */
+    struct assoc_exp_stats exp_stats;
 };
 
 /* assoc scan structure */
@@ -57,6 +96,7 @@ struct assoc_scan {
     int        bucket;    /* current bucket index */
     int        tabcnt;    /* table count in the bucket */
     int        tabidx;    /* table index in the bucket */
+    int        slotidx;   /* slot index in the bucket of the table */
     hash_item  ph_item;   /* placeholder item itself */
     bool       ph_linked; /* placeholder item linked */
     bool       initialized;
@@ -71,6 +111,11 @@ int               assoc_insert(hash_item *item, uint32_t hash);
 void              assoc_replace(hash_item *old_it, hash_item *new_it);
 void              assoc_delete(const char *key, const uint32_t nkey, uint32_t hash);
 
+/* hash table expansion thread */
+int               assoc_thread_start(void);
+void              assoc_thread_stop(void);
+void              assoc_stats(ADD_STAT add_stat, const void *cookie);
+
 /* assoc scan functions */
 void              assoc_scan_init(struct assoc_scan *scan);
 int               assoc_scan_next(struct assoc_scan *scan, hash_item **item_array,
@@ -38,17 +38,6 @@ static struct default_engine *engine=NULL;
 static struct engine_config  *config=NULL; // engine config
 static EXTENSION_LOGGER_DESCRIPTOR *logger;
 
-/* Cache Lock */
-static inline void LOCK_CACHE(void)
-{
-    pthread_mutex_lock(&engine->cache_lock);
-}
-
-static inline void UNLOCK_CACHE(void)
-{
-    pthread_mutex_unlock(&engine->cache_lock);
-}
-
 /* bkey type */
 #define BKEY_TYPE_UNKNOWN 0
 #define BKEY_TYPE_UINT64  1
@@ -308,13 +297,28 @@ static void do_btree_elem_free(btree_elem_item *elem)
 static void do_btree_elem_release(btree_elem_item *elem)
 {
     /* assert(elem->status != BTREE_ITEM_STATUS_FREE); */
+    LOCK_ELEM(elem);
     if (elem->refcount != 0) {
-        elem->refcount--;
+        ELEM_REFCOUNT_DECR(elem);
     }
     if (elem->refcount == 0 && elem->status == BTREE_ITEM_STATUS_UNLINK) {
         elem->status = BTREE_ITEM_STATUS_FREE;
         do_btree_elem_free(elem);
     }
+    UNLOCK_ELEM(elem);
+}
+
+/* Mark the element unlinked, and free it if it's not referenced. */
+static void do_btree_elem_unlinked(btree_elem_item *elem)
+{
+    LOCK_ELEM(elem);
+    if (elem->refcount > 0) {
+        elem->status = BTREE_ITEM_STATUS_UNLINK;
+    } else {
+        elem->status = BTREE_ITEM_STATUS_FREE;
+        do_btree_elem_free(elem);
+    }
+    UNLOCK_ELEM(elem);
 }
 
 static inline btree_elem_item *do_btree_get_first_elem(btree_indx_node *node)
@@ -1666,12 +1670,7 @@ static void do_btree_elem_unlink(btree_meta_info *info, btree_elem_posi *path,
 
     CLOG_BTREE_ELEM_DELETE(info, elem, cause);
 
-    if (elem->refcount > 0) {
-        elem->status = BTREE_ITEM_STATUS_UNLINK;
-    } else  {
-        elem->status = BTREE_ITEM_STATUS_FREE;
-        do_btree_elem_free(elem);
-    }
+    do_btree_elem_unlinked(elem);
 
     /* remove the element from the leaf node */
     btree_indx_node *node = posi->node;
@@ -1703,12 +1702,7 @@ static void do_btree_elem_replace(btree_meta_info *info,
 
     CLOG_BTREE_ELEM_INSERT(info, old_elem, new_elem);
 
-    if (old_elem->refcount > 0) {
-        old_elem->status = BTREE_ITEM_STATUS_UNLINK;
-    } else  {
-        old_elem->status = BTREE_ITEM_STATUS_FREE;
-        do_btree_elem_free(old_elem);
-    }
+    do_btree_elem_unlinked(old_elem);
 
     new_elem->status = BTREE_ITEM_STATUS_USED;
     posi->node->item[posi->indx] = new_elem;
@@ -1850,12 +1844,7 @@ static int do_btree_elem_delete_fast(btree_meta_info *info,
         if (node->ndepth == 0) { /* leaf node */
             for (i = 0; i < node->used_count; i++) {
                 elem = (btree_elem_item *)node->item[i];
-                if (elem->refcount > 0) {
-                    elem->status = BTREE_ITEM_STATUS_UNLINK;
-                } else {
-                    elem->status = BTREE_ITEM_STATUS_FREE;
-                    do_btree_elem_free(elem);
-                }
+                do_btree_elem_unlinked(elem);
             }
         } else {
             for (i = 0; i < node->used_count; i++) {
@@ -1945,12 +1934,7 @@ static uint32_t do_btree_elem_delete(btree_meta_info *info,
                     tot_space += slabs_space_size(do_btree_elem_ntotal(elem));
 
                     CLOG_BTREE_ELEM_DELETE(info, elem, cause);
-                    if (elem->refcount > 0) {
-                        elem->status = BTREE_ITEM_STATUS_UNLINK;
-                    } else {
-                        elem->status = BTREE_ITEM_STATUS_FREE;
-                        do_btree_elem_free(elem);
-                    }
+                    do_btree_elem_unlinked(elem);
                     c_posi.node->item[c_posi.indx] = NULL;
 
                     cur_found++;
@@ -2190,7 +2174,7 @@ static void do_btree_overflow_trim(btree_meta_info *info,
         }
         if (trimmed_elems != NULL) {
             btree_elem_item *edge_elem = BTREE_GET_ELEM_ITEM(delpath[0].node, delpath[0].indx);
-            edge_elem->refcount++;
+            ELEM_REFCOUNT_INCR(edge_elem);
             *trimmed_elems = edge_elem;
             *trimmed_count = 1;
         }
@@ -2350,7 +2334,7 @@ static uint32_t do_btree_elem_get(btree_meta_info *info,
         assert(path[0].bkeq == true);
         if (opcost) *opcost += 1;
         if (offset == 0 && (efilter == NULL || do_btree_elem_filter(elem, efilter))) {
-            elem->refcount++;
+            ELEM_REFCOUNT_INCR(elem);
             elem_array[tot_found++] = elem;
             if (delete) {
                 do_btree_elem_unlink(info, path, ELEM_DELETE_NORMAL);
@@ -2391,7 +2375,7 @@ static uint32_t do_btree_elem_get(btree_meta_info *info,
                 if (skip_cnt < offset) {
                     skip_cnt++;
                 } else {
-                    elem->refcount++;
+                    ELEM_REFCOUNT_INCR(elem);
                     elem_array[tot_found+cur_found] = elem;
                     if (delete) {
                         tot_space += slabs_space_size(do_btree_elem_ntotal(elem));
@@ -2728,7 +2712,7 @@ static int do_btree_elem_batch_get(btree_elem_posi posi, const int count,
         if (posi.node == NULL) break;
 
         elem = BTREE_GET_ELEM_ITEM(posi.node, posi.indx);
-        elem->refcount++;
+        ELEM_REFCOUNT_INCR(elem);
         if (reverse) elem_array[count-nfound-1] = elem;
         else         elem_array[nfound] = elem;
         nfound += 1;
@@ -2757,7 +2741,7 @@ static int do_btree_posi_find_with_get(btree_meta_info *info,
 
         ecnt = 1;                             /* elem count */
         eidx = (bpos < count) ? bpos : count; /* elem index in elem array */
-        elem->refcount++;
+        ELEM_REFCOUNT_INCR(elem);
         elem_array[eidx] = elem;
 
         if (order == BTREE_ORDER_ASC) {
@@ -2804,7 +2788,7 @@ static ENGINE_ERROR_CODE do_btree_elem_get_by_posi(btree_meta_info *info,
     posi.bkeq = false;
 
     elem = BTREE_GET_ELEM_ITEM(posi.node, posi.indx);
-    elem->refcount++;
+    ELEM_REFCOUNT_INCR(elem);
     elem_array[0] = elem;
     nfound = 1;
     nfound += do_btree_elem_batch_get(posi, count-1, forward, false, &elem_array[nfound]);
@@ -2980,7 +2964,7 @@ static void do_btree_smget_adjust_trim(smget_result_t *smres)
             }
             pos = left;
         }
-        trim_elem->refcount++;
+        ELEM_REFCOUNT_INCR(trim_elem);
         new_trim_elems[pos] = trim_elem;
         new_trim_kinfo[pos].kidx = trim_kidx;
         new_trim_count++;
@@ -3440,7 +3424,7 @@ static ENGINE_ERROR_CODE do_btree_smget_elem_sort_old(btree_scan_info *btree_sca
             if (*elem_count > 0 && dup_bkey_found) {
                 *bkey_duplicated = true;
             }
-            elem->refcount++;
+            ELEM_REFCOUNT_INCR(elem);
             elem_array[*elem_count] = elem;
             kfnd_array[*elem_count] = btree_scan_buf[curr_idx].kidx;
             flag_array[*elem_count] = btree_scan_buf[curr_idx].it->flags;
@@ -3571,7 +3555,7 @@ do_btree_smget_elem_sort(btree_scan_info *btree_scan_buf,
                 }
             }
 #endif
-            elem->refcount++;
+            ELEM_REFCOUNT_INCR(elem);
             if (smres->elem_count >= count) break;
         }
 
@@ -3659,7 +3643,7 @@ ENGINE_ERROR_CODE btree_struct_create(const char *key, const uint32_t nkey,
     ENGINE_ERROR_CODE ret;
     PERSISTENCE_ACTION_BEGIN(cookie, UPD_BT_CREATE);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     it = do_item_get(key, nkey, DONT_UPDATE);
     if (it != NULL) {
         do_item_release(it);
@@ -3683,7 +3667,7 @@ btree_elem_item *btree_elem_alloc(const uint32_t nbkey, const uint32_t neflag, c
                                   const void *cookie)
 {
     btree_elem_item *elem;
-    LOCK_CACHE();
+    LOCK_CACHE_ANY();
     elem = do_btree_elem_alloc(nbkey, neflag, nbytes, cookie);
     UNLOCK_CACHE();
     return elem;
@@ -3691,25 +3675,17 @@ btree_elem_item *btree_elem_alloc(const uint32_t nbkey, const uint32_t neflag, c
 
 void btree_elem_free(btree_elem_item *elem)
 {
-    LOCK_CACHE();
     assert(elem->status == BTREE_ITEM_STATUS_UNLINK);
     elem->status = BTREE_ITEM_STATUS_FREE;
     do_btree_elem_free(elem);
-    UNLOCK_CACHE();
 }
 
 void btree_elem_release(btree_elem_item **elem_array, const int elem_count)
 {
-    int cnt = 0;
-    LOCK_CACHE();
-    while (cnt < elem_count) {
-        do_btree_elem_release(elem_array[cnt++]);
-        if ((cnt % 100) == 0 && cnt < elem_count) {
-            UNLOCK_CACHE();
-            LOCK_CACHE();
-        }
+    /* The elements are released without the cache lock */
+    for (int cnt = 0; cnt < elem_count; cnt++) {
+        do_btree_elem_release(elem_array[cnt]);
     }
-    UNLOCK_CACHE();
 }
 
 ENGINE_ERROR_CODE btree_elem_insert(const char *key, const uint32_t nkey,
@@ -3730,7 +3706,7 @@ ENGINE_ERROR_CODE btree_elem_insert(const char *key, const uint32_t nkey,
         *trimmed_count = 0;
     }
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_btree_item_find(key, nkey, DONT_UPDATE, &it);
     if (ret == ENGINE_KEY_ENOENT && attrp != NULL) {
         it = do_btree_item_alloc(key, nkey, attrp, cookie);
@@ -3772,7 +3748,7 @@ ENGINE_ERROR_CODE btree_elem_update(const char *key, const uint32_t nkey, const
     assert(bkrtype == BKEY_RANGE_TYPE_SIN); /* single bkey */
     PERSISTENCE_ACTION_BEGIN(cookie, UPD_BT_ELEM_INSERT);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_btree_item_find(key, nkey, DONT_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) {
         btree_meta_info *info = (btree_meta_info *)item_get_meta(it);
@@ -3806,7 +3782,7 @@ ENGINE_ERROR_CODE btree_elem_delete(const char *key, const uint32_t nkey,
     PERSISTENCE_ACTION_BEGIN(cookie, (drop_if_empty ? UPD_BT_ELEM_DELETE_DROP
                                                     : UPD_BT_ELEM_DELETE));
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_btree_item_find(key, nkey, DONT_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) {
         btree_meta_info *info = (btree_meta_info *)item_get_meta(it);
@@ -3853,7 +3829,7 @@ ENGINE_ERROR_CODE btree_elem_arithmetic(const char *key, const uint32_t nkey,
     assert(bkrtype == BKEY_RANGE_TYPE_SIN); /* single bkey */
     PERSISTENCE_ACTION_BEGIN(cookie, UPD_BT_ELEM_INSERT);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_btree_item_find(key, nkey, DONT_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) {
         bool new_root_flag = false;
@@ -3907,7 +3883,7 @@ ENGINE_ERROR_CODE btree_elem_get(const char *key, const uint32_t nkey,
                                                         : UPD_BT_ELEM_DELETE));
     }
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_btree_item_find(key, nkey, DO_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) {
         btree_meta_info *info = (btree_meta_info *)item_get_meta(it);
@@ -3975,7 +3951,7 @@ ENGINE_ERROR_CODE btree_elem_count(const char *key, const uint32_t nkey,
     ENGINE_ERROR_CODE ret;
     int bkrtype = do_btree_bkey_range_type(bkrange);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_btree_item_find(key, nkey, DO_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) {
         btree_meta_info *info = (btree_meta_info *)item_get_meta(it);
@@ -4003,7 +3979,7 @@ ENGINE_ERROR_CODE btree_posi_find(const char *key, const uint32_t nkey, const bk
     int bkrtype = do_btree_bkey_range_type(bkrange);
     assert(bkrtype == BKEY_RANGE_TYPE_SIN);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_btree_item_find(key, nkey, DO_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) {
         btree_meta_info *info = (btree_meta_info *)item_get_meta(it);
@@ -4039,7 +4015,7 @@ ENGINE_ERROR_CODE btree_posi_find_with_get(const char *key, const uint32_t nkey,
     int bkrtype = do_btree_bkey_range_type(bkrange);
     assert(bkrtype == BKEY_RANGE_TYPE_SIN);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_btree_item_find(key, nkey, DO_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) {
         btree_meta_info *info = (btree_meta_info *)item_get_meta(it);
@@ -4083,7 +4059,7 @@ ENGINE_ERROR_CODE btree_elem_get_by_posi(const char *key, const uint32_t nkey,
     hash_item *it;
     ENGINE_ERROR_CODE ret;
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_btree_item_find(key, nkey, DO_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) {
         uint32_t rqcount;
@@ -4157,7 +4133,7 @@ ENGINE_ERROR_CODE btree_elem_smget_old(token_t *key_array, const int key_count,
     *trimmed = false;
     *duplicated = false;
 
-    LOCK_CACHE();
+    LOCK_CACHE_ALL();
     /* the 1st phase: get the sorted scans */
     ret = do_btree_smget_scan_sort_old(key_array, key_count,
                                    bkrtype, bkrange, efilter, (offset+count),
@@ -4201,7 +4177,7 @@ ENGINE_ERROR_CODE btree_elem_smget(token_t *key_array, const int key_count,
     /* set the ascending field of smget result */
     result->ascending = (bkrtype != BKEY_RANGE_TYPE_DSC ? true : false);
 
-    LOCK_CACHE();
+    LOCK_CACHE_ALL();
     do {
         /* the 1st phase: get the sorted scans */
         ret = do_btree_smget_scan_sort(key_array, key_count,
@@ -4251,7 +4227,7 @@ void btree_elem_get_all(btree_meta_info *info, elems_result_t *eresult)
 
     elem = do_btree_find_first(info->root, BKEY_RANGE_TYPE_ASC, NULL, &posi, false);
     while (elem != NULL) {
-        elem->refcount++;
+        ELEM_REFCOUNT_INCR(elem);
         eresult->elem_array[eresult->elem_count++] = elem;
         /* Never have to go backward?  FIXME */
         elem = do_btree_find_next(&posi, NULL);
@@ -4392,7 +4368,7 @@ ENGINE_ERROR_CODE btree_apply_item_link(void *engine, const char *key, const uin
     logger->log(ITEM_APPLY_LOG_LEVEL, NULL, "btree_apply_item_link. key=%.*s nkey=%u\n",
                 PRINT_NKEY(nkey), key, nkey);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     old_it = do_item_get(key, nkey, DONT_UPDATE);
     if (old_it) {
         /* Remove the old item first. */
@@ -4443,7 +4419,7 @@ ENGINE_ERROR_CODE btree_apply_elem_insert(void *engine, hash_item *it,
                 "btree_apply_elem_insert. key=%.*s nkey=%u bkey=%.*s nbkey=%u\n",
                 PRINT_NKEY(it->nkey), key, it->nkey, nbkey, bkey, nbkey);
 
-    LOCK_CACHE();
+    LOCK_CACHE(it->khash);
     do {
         if (!item_is_valid(it)) {
             logger->log(EXTENSION_LOG_WARNING, NULL, "btree_apply_elem_insert failed."
@@ -4497,7 +4473,7 @@ ENGINE_ERROR_CODE btree_apply_elem_delete(void *engine, hash_item *it,
     /* bkey_range.to_bkey */
     bkrange.to_nbkey = BKEY_NULL;
 
-    LOCK_CACHE();
+    LOCK_CACHE(it->khash);
     do {
         if (!item_is_valid(it)) {
             logger->log(EXTENSION_LOG_WARNING, NULL, "btree_apply_elem_delete failed."
@@ -4558,7 +4534,7 @@ ENGINE_ERROR_CODE btree_apply_elem_delete_logical(void *engine, hash_item *it,
                 "btree_apply_elem_delete_logical. key=%.*s nkey=%u\n",
                 PRINT_NKEY(it->nkey), key, it->nkey);
 
-    LOCK_CACHE();
+    LOCK_CACHE(it->khash);
     do {
         if (!item_is_valid(it)) {
             logger->log(EXTENSION_LOG_WARNING, NULL, "btree_apply_elem_delete_logical failed."
@@ -38,17 +38,6 @@ static struct default_engine *engine=NULL;
 static struct engine_config  *config=NULL; // engine config
 static EXTENSION_LOGGER_DESCRIPTOR *logger;
 
-/* Cache Lock */
-static inline void LOCK_CACHE(void)
-{
-    pthread_mutex_lock(&engine->cache_lock);
-}
-
-static inline void UNLOCK_CACHE(void)
-{
-    pthread_mutex_unlock(&engine->cache_lock);
-}
-
 /*
  * LIST collection management
  */
@@ -147,12 +136,14 @@ static void do_list_elem_free(list_elem_item *elem)
 
 static void do_list_elem_release(list_elem_item *elem)
 {
+    LOCK_ELEM(elem);
     if (elem->refcount != 0) {
-        elem->refcount--;
+        ELEM_REFCOUNT_DECR(elem);
     }
     if (elem->refcount == 0 && elem->next == (list_elem_item *)ADDR_MEANS_UNLINKED) {
         do_list_elem_free(elem);
     }
+    UNLOCK_ELEM(elem);
 }
 
 static list_elem_item *do_list_elem_find(list_meta_info *info, int index)
@@ -216,7 +207,6 @@ static void do_list_elem_unlink(list_meta_info *info, list_elem_item *elem,
         else                    elem->prev->next = elem->next;
         if (elem->next == NULL) info->tail = elem->prev;
         else                    elem->next->prev = elem->prev;
-        elem->prev = elem->next = (list_elem_item *)ADDR_MEANS_UNLINKED;
         info->ccnt--;
 
         if (info->stotal > 0) { /* apply memory space */
@@ -224,9 +214,12 @@ static void do_list_elem_unlink(list_meta_info *info, list_elem_item *elem,
             do_coll_space_decr((coll_meta_info *)info, ITEM_TYPE_LIST, stotal);
         }
 
+        LOCK_ELEM(elem);
+        elem->prev = elem->next = (list_elem_item *)ADDR_MEANS_UNLINKED;
         if (elem->refcount == 0) {
             do_list_elem_free(elem);
         }
+        UNLOCK_ELEM(elem);
     }
 }
 
@@ -268,7 +261,7 @@ static uint32_t do_list_elem_get(list_meta_info *info,
     elem = do_list_elem_find(info, index);
     while (elem != NULL) {
         tobe = (forward ? elem->next : elem->prev);
-        elem->refcount++;
+        ELEM_REFCOUNT_INCR(elem);
         elem_array[fcnt++] = elem;
         if (delete) do_list_elem_unlink(info, elem, cause);
         if (count > 0 && fcnt >= count) break;
@@ -358,7 +351,7 @@ ENGINE_ERROR_CODE list_struct_create(const char *key, const uint32_t nkey,
     ENGINE_ERROR_CODE ret;
     PERSISTENCE_ACTION_BEGIN(cookie, UPD_LIST_CREATE);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     it = do_item_get(key, nkey, DONT_UPDATE);
     if (it != NULL) {
         do_item_release(it);
@@ -381,7 +374,7 @@ ENGINE_ERROR_CODE list_struct_create(const char *key, const uint32_t nkey,
 list_elem_item *list_elem_alloc(const uint32_t nbytes, const void *cookie)
 {
     list_elem_item *elem;
-    LOCK_CACHE();
+    LOCK_CACHE_ANY();
     elem = do_list_elem_alloc(nbytes, cookie);
     UNLOCK_CACHE();
     return elem;
@@ -389,24 +382,16 @@ list_elem_item *list_elem_alloc(const uint32_t nbytes, const void *cookie)
 
 void list_elem_free(list_elem_item *elem)
 {
-    LOCK_CACHE();
     assert(elem->next == (list_elem_item *)ADDR_MEANS_UNLINKED);
     do_list_elem_free(elem);
-    UNLOCK_CACHE();
 }
 
 void list_elem_release(list_elem_item **elem_array, const int elem_count)
 {
-    int cnt = 0;
-    LOCK_CACHE();
-    while (cnt < elem_count) {
-        do_list_elem_release(elem_array[cnt++]);
-        if ((cnt % 100) == 0 && cnt < elem_count) {
-            UNLOCK_CACHE();
-            LOCK_CACHE();
-        }
+    /* The elements are released without the cache lock */
+    for (int cnt = 0; cnt < elem_count; cnt++) {
+        do_list_elem_release(elem_array[cnt]);
     }
-    UNLOCK_CACHE();
 }
 
 ENGINE_ERROR_CODE list_elem_insert(const char *key, const uint32_t nkey,
@@ -420,7 +405,7 @@ ENGINE_ERROR_CODE list_elem_insert(const char *key, const uint32_t nkey,
 
     *created = false;
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_list_item_find(key, nkey, DONT_UPDATE, &it);
     if (ret == ENGINE_KEY_ENOENT && attrp != NULL) {
         it = do_list_item_alloc(key, nkey, attrp, cookie);
@@ -485,7 +470,7 @@ ENGINE_ERROR_CODE list_elem_delete(const char *key, const uint32_t nkey,
     PERSISTENCE_ACTION_BEGIN(cookie, (drop_if_empty ? UPD_LIST_ELEM_DELETE_DROP
                                                     : UPD_LIST_ELEM_DELETE));
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_list_item_find(key, nkey, DONT_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) {
         int      index;
@@ -536,7 +521,7 @@ ENGINE_ERROR_CODE list_elem_get(const char *key, const uint32_t nkey,
                                                         : UPD_LIST_ELEM_DELETE));
     }
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_list_item_find(key, nkey, DO_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) {
         int      index;
@@ -597,7 +582,7 @@ void list_elem_get_all(list_meta_info *info, elems_result_t *eresult)
 
     elem = do_list_elem_find(info, 0);
     while (elem != NULL) {
-        elem->refcount++;
+        ELEM_REFCOUNT_INCR(elem);
         eresult->elem_array[eresult->elem_count++] = elem;
         elem = elem->next;
     }
@@ -677,7 +662,7 @@ ENGINE_ERROR_CODE list_apply_item_link(void *engine, const char *key, const uint
     logger->log(ITEM_APPLY_LOG_LEVEL, NULL, "list_apply_item_link. key=%.*s nkey=%u\n",
                 PRINT_NKEY(nkey), key, nkey);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     old_it = do_item_get(key, nkey, DONT_UPDATE);
     if (old_it) {
         /* Remove the old item first. */
@@ -720,7 +705,7 @@ ENGINE_ERROR_CODE list_apply_elem_insert(void *engine, hash_item *it,
                 "list_apply_elem_insert. key=%.*s nkey=%u nelems=%d index=%d\n",
                 PRINT_NKEY(it->nkey), key, it->nkey, nelems, index);
 
-    LOCK_CACHE();
+    LOCK_CACHE(it->khash);
     do {
         if (!item_is_valid(it)) {
             logger->log(EXTENSION_LOG_WARNING, NULL, "list_apply_elem_insert failed."
@@ -774,7 +759,7 @@ ENGINE_ERROR_CODE list_apply_elem_delete(void *engine, hash_item *it,
                 "list_apply_elem_delete. key=%.*s nkey=%u index=%d, count=%d\n",
                 PRINT_NKEY(it->nkey), key, it->nkey, index, count);
 
-    LOCK_CACHE();
+    LOCK_CACHE(it->khash);
     do {
         if (!item_is_valid(it)) {
             logger->log(EXTENSION_LOG_WARNING, NULL, "list_apply_elem_delete failed."
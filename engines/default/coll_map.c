@@ -41,17 +41,6 @@ static EXTENSION_LOGGER_DESCRIPTOR *logger;
 /* used by set and map collection */
 extern int genhash_string_hash(const void* p, size_t nkey);
 
-/* Cache Lock */
-static inline void LOCK_CACHE(void)
-{
-    pthread_mutex_lock(&engine->cache_lock);
-}
-
-static inline void UNLOCK_CACHE(void)
-{
-    pthread_mutex_unlock(&engine->cache_lock);
-}
-
 /*
  * MAP collection manangement
  */
@@ -192,12 +181,14 @@ static void do_map_elem_free(map_elem_item *elem)
 
 static void do_map_elem_release(map_elem_item *elem)
 {
+    LOCK_ELEM(elem);
     if (elem->refcount != 0) {
-        elem->refcount--;
+        ELEM_REFCOUNT_DECR(elem);
     }
     if (elem->refcount == 0 && elem->next == (map_elem_item *)ADDR_MEANS_UNLINKED) {
         do_map_elem_free(elem);
     }
+    UNLOCK_ELEM(elem);
 }
 
 static void do_map_node_link(map_meta_info *info,
@@ -314,10 +305,12 @@ static void do_map_elem_replace(map_meta_info *info,
         pinfo->node->htab[pinfo->hidx] = new_elem;
     }
 
+    LOCK_ELEM(old_elem);
     old_elem->next = (map_elem_item *)ADDR_MEANS_UNLINKED;
     if (old_elem->refcount == 0) {
         do_map_elem_free(old_elem);
     }
+    UNLOCK_ELEM(old_elem);
 
     if (new_stotal != old_stotal) {
         assert(info->stotal > 0);
@@ -431,7 +424,6 @@ static void do_map_elem_unlink(map_meta_info *info,
 {
     if (prev != NULL) prev->next = elem->next;
     else              node->htab[hidx] = elem->next;
-    elem->next = (map_elem_item *)ADDR_MEANS_UNLINKED;
     node->hcnt[hidx] -= 1;
     node->cur_elem_cnt -= 1;
     info->ccnt--;
@@ -443,9 +435,12 @@ static void do_map_elem_unlink(map_meta_info *info,
         do_coll_space_decr((coll_meta_info *)info, ITEM_TYPE_MAP, stotal);
     }
 
+    LOCK_ELEM(elem);
+    elem->next = (map_elem_item *)ADDR_MEANS_UNLINKED;
     if (elem->refcount == 0) {
         do_map_elem_free(elem);
     }
+    UNLOCK_ELEM(elem);
 }
 
 static bool do_map_elem_traverse_dfs_byfield(map_meta_info *info, map_hash_node *node, const int hval,
@@ -472,7 +467,7 @@ static bool do_map_elem_traverse_dfs_byfield(map_meta_info *info, map_hash_node
             while (elem != NULL) {
                 if (map_hash_eq(hval, field->value, field->length, elem->hval, elem->data, elem->nfield)) {
                     if (elem_array) {
-                        elem->refcount++;
+                        ELEM_REFCOUNT_INCR(elem);
                         elem_array[0] = elem;
                     }
 
@@ -513,7 +508,7 @@ static int do_map_elem_traverse_dfs_bycnt(map_meta_info *info, map_hash_node *no
             map_elem_item *elem = node->htab[hidx];
             while (elem != NULL) {
                 if (elem_array) {
-                    elem->refcount++;
+                    ELEM_REFCOUNT_INCR(elem);
                     elem_array[fcnt] = elem;
                 }
                 fcnt++;
@@ -716,7 +711,7 @@ ENGINE_ERROR_CODE map_struct_create(const char *key, const uint32_t nkey,
     ENGINE_ERROR_CODE ret;
     PERSISTENCE_ACTION_BEGIN(cookie, UPD_MAP_CREATE);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     it = do_item_get(key, nkey, DONT_UPDATE);
     if (it != NULL) {
         do_item_release(it);
@@ -739,7 +734,7 @@ ENGINE_ERROR_CODE map_struct_create(const char *key, const uint32_t nkey,
 map_elem_item *map_elem_alloc(const int nfield, const uint32_t nbytes, const void *cookie)
 {
     map_elem_item *elem;
-    LOCK_CACHE();
+    LOCK_CACHE_ANY();
     elem = do_map_elem_alloc(nfield, nbytes, cookie);
     UNLOCK_CACHE();
     return elem;
@@ -747,24 +742,16 @@ map_elem_item *map_elem_alloc(const int nfield, const uint32_t nbytes, const voi
 
 void map_elem_free(map_elem_item *elem)
 {
-    LOCK_CACHE();
     assert(elem->next == (map_elem_item *)ADDR_MEANS_UNLINKED);
     do_map_elem_free(elem);
-    UNLOCK_CACHE();
 }
 
 void map_elem_release(map_elem_item **elem_array, const int elem_count)
 {
-    int cnt = 0;
-    LOCK_CACHE();
-    while (cnt < elem_count) {
-        do_map_elem_release(elem_array[cnt++]);
-        if ((cnt % 100) == 0 && cnt < elem_count) {
-            UNLOCK_CACHE();
-            LOCK_CACHE();
-        }
+    /* The elements are released without the cache lock */
+    for (int cnt = 0; cnt < elem_count; cnt++) {
+        do_map_elem_release(elem_array[cnt]);
     }
-    UNLOCK_CACHE();
 }
 
 ENGINE_ERROR_CODE map_elem_insert(const char *key, const uint32_t nkey,
@@ -779,7 +766,7 @@ ENGINE_ERROR_CODE map_elem_insert(const char *key, const uint32_t nkey,
     *created = false;
     *replaced = false;
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_map_item_find(key, nkey, DONT_UPDATE, &it);
     if (ret == ENGINE_KEY_ENOENT && attrp != NULL) {
         it = do_map_item_alloc(key, nkey, attrp, cookie);
@@ -815,7 +802,7 @@ ENGINE_ERROR_CODE map_elem_update(const char *key, const uint32_t nkey,
     ENGINE_ERROR_CODE ret;
     PERSISTENCE_ACTION_BEGIN(cookie, UPD_MAP_ELEM_INSERT);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_map_item_find(key, nkey, DONT_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) { /* it != NULL */
         map_meta_info *info = (map_meta_info *)item_get_meta(it);
@@ -841,7 +828,7 @@ ENGINE_ERROR_CODE map_elem_delete(const char *key, const uint32_t nkey,
 
     *dropped = false;
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_map_item_find(key, nkey, DONT_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) { /* it != NULL */
         map_meta_info *info = (map_meta_info *)item_get_meta(it);
@@ -876,7 +863,7 @@ ENGINE_ERROR_CODE map_elem_get(const char *key, const uint32_t nkey,
                                                         : UPD_MAP_ELEM_DELETE));
     }
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_map_item_find(key, nkey, DO_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) {
         map_meta_info *info = (map_meta_info *)item_get_meta(it);
@@ -972,7 +959,7 @@ void map_elem_get_all(map_meta_info *info, elems_result_t *eresult)
                  * to-be-copied list.
                  */
                 for (elem = node->htab[i]; elem != NULL; elem = elem->next) {
-                    elem->refcount++;
+                    ELEM_REFCOUNT_INCR(elem);
                     eresult->elem_array[eresult->elem_count++] = elem;
                 }
             }
@@ -1069,7 +1056,7 @@ ENGINE_ERROR_CODE map_apply_item_link(void *engine, const char *key, const uint3
     logger->log(ITEM_APPLY_LOG_LEVEL, NULL, "map_apply_item_link. key=%.*s nkey=%u\n",
                 PRINT_NKEY(nkey), key, nkey);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     old_it = do_item_get(key, nkey, DONT_UPDATE);
     if (old_it) {
         /* Remove the old item first. */
@@ -1112,7 +1099,7 @@ ENGINE_ERROR_CODE map_apply_elem_insert(void *engine, hash_item *it,
                 "map_apply_elem_insert. key=%.*s nkey=%u field=%.*s nfield=%u\n",
                 PRINT_NKEY(it->nkey), key, it->nkey, nfield, field, nfield);
 
-    LOCK_CACHE();
+    LOCK_CACHE(it->khash);
     do {
         if (!item_is_valid(it)) {
             logger->log(EXTENSION_LOG_WARNING, NULL, "map_apply_elem_insert failed."
@@ -1162,7 +1149,7 @@ ENGINE_ERROR_CODE map_apply_elem_delete(void *engine, hash_item *it,
                 "map_apply_elem_delete. key=%.*s nkey=%u field=%.*s nfield=%u\n",
                 PRINT_NKEY(it->nkey), key, it->nkey, nfield, field, nfield);
 
-    LOCK_CACHE();
+    LOCK_CACHE(it->khash);
     do {
         if (!item_is_valid(it)) {
             logger->log(EXTENSION_LOG_WARNING, NULL, "map_apply_elem_delete failed."
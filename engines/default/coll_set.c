@@ -41,17 +41,6 @@ static EXTENSION_LOGGER_DESCRIPTOR *logger;
 /* used by set and map collection */
 extern int genhash_string_hash(const void* p, size_t nkey);
 
-/* Cache Lock */
-static inline void LOCK_CACHE(void)
-{
-    pthread_mutex_lock(&engine->cache_lock);
-}
-
-static inline void UNLOCK_CACHE(void)
-{
-    pthread_mutex_unlock(&engine->cache_lock);
-}
-
 /*
  * Hash table management
  */
@@ -238,12 +227,14 @@ static void do_set_elem_free(set_elem_item *elem)
 
 static void do_set_elem_release(set_elem_item *elem)
 {
+    LOCK_ELEM(elem);
     if (elem->refcount != 0) {
-        elem->refcount--;
+        ELEM_REFCOUNT_DECR(elem);
     }
     if (elem->refcount == 0 && elem->next == (set_elem_item *)ADDR_MEANS_UNLINKED) {
         do_set_elem_free(elem);
     }
+    UNLOCK_ELEM(elem);
 }
 
 static void do_set_node_link(set_meta_info *info,
@@ -392,7 +383,6 @@ static void do_set_elem_unlink(set_meta_info *info,
 {
     if (prev != NULL) prev->next = elem->next;
     else              node->htab[hidx] = elem->next;
-    elem->next = (set_elem_item *)ADDR_MEANS_UNLINKED;
     node->hcnt[hidx] -= 1;
     node->tot_elem_cnt -= 1;
     info->ccnt--;
@@ -404,9 +394,12 @@ static void do_set_elem_unlink(set_meta_info *info,
         do_coll_space_decr((coll_meta_info *)info, ITEM_TYPE_SET, stotal);
     }
 
+    LOCK_ELEM(elem);
+    elem->next = (set_elem_item *)ADDR_MEANS_UNLINKED;
     if (elem->refcount == 0) {
         do_set_elem_free(elem);
     }
+    UNLOCK_ELEM(elem);
 }
 
 static set_elem_item *do_set_elem_find(set_meta_info *info, const char *val, const int vlen)
@@ -516,7 +509,7 @@ static int do_set_elem_traverse_dfs(set_meta_info *info, set_hash_node *node,
             set_elem_item *elem = node->htab[hidx];
             while (elem != NULL) {
                 if (elem_array) {
-                    elem->refcount++;
+                    ELEM_REFCOUNT_INCR(elem);
                     elem_array[fcnt] = elem;
                 }
                 fcnt++;
@@ -564,7 +557,7 @@ static set_elem_item *do_set_elem_at_offset(set_meta_info *info, set_hash_node *
                 elem = elem->next;
                 offset -= 1;
             }
-            elem->refcount++;
+            ELEM_REFCOUNT_INCR(elem);
             if (delete) do_set_elem_unlink(info, node, hidx, prev, elem,
                                            ELEM_DELETE_NORMAL);
             return elem;
@@ -698,7 +691,7 @@ ENGINE_ERROR_CODE set_struct_create(const char *key, const uint32_t nkey,
     ENGINE_ERROR_CODE ret;
     PERSISTENCE_ACTION_BEGIN(cookie, UPD_SET_CREATE);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     it = do_item_get(key, nkey, DONT_UPDATE);
     if (it != NULL) {
         do_item_release(it);
@@ -721,7 +714,7 @@ ENGINE_ERROR_CODE set_struct_create(const char *key, const uint32_t nkey,
 set_elem_item *set_elem_alloc(const uint32_t nbytes, const void *cookie)
 {
     set_elem_item *elem;
-    LOCK_CACHE();
+    LOCK_CACHE_ANY();
     elem = do_set_elem_alloc(nbytes, cookie);
     UNLOCK_CACHE();
     return elem;
@@ -729,24 +722,16 @@ set_elem_item *set_elem_alloc(const uint32_t nbytes, const void *cookie)
 
 void set_elem_free(set_elem_item *elem)
 {
-    LOCK_CACHE();
     assert(elem->next == (set_elem_item *)ADDR_MEANS_UNLINKED);
     do_set_elem_free(elem);
-    UNLOCK_CACHE();
 }
 
 void set_elem_release(set_elem_item **elem_array, const int elem_count)
 {
-    int cnt = 0;
-    LOCK_CACHE();
-    while (cnt < elem_count) {
-        do_set_elem_release(elem_array[cnt++]);
-        if ((cnt % 100) == 0 && cnt < elem_count) {
-            UNLOCK_CACHE();
-            LOCK_CACHE();
-        }
+    /* The elements are released without the cache lock */
+    for (int cnt = 0; cnt < elem_count; cnt++) {
+        do_set_elem_release(elem_array[cnt]);
     }
-    UNLOCK_CACHE();
 }
 
 ENGINE_ERROR_CODE set_elem_insert(const char *key, const uint32_t nkey,
@@ -759,7 +744,7 @@ ENGINE_ERROR_CODE set_elem_insert(const char *key, const uint32_t nkey,
 
     *created = false;
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_set_item_find(key, nkey, DONT_UPDATE, &it);
     if (ret == ENGINE_KEY_ENOENT && attrp != NULL) {
         it = do_set_item_alloc(key, nkey, attrp, cookie);
@@ -800,7 +785,7 @@ ENGINE_ERROR_CODE set_elem_delete(const char *key, const uint32_t nkey,
 
     *dropped = false;
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_set_item_find(key, nkey, DONT_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) { /* it != NULL */
         set_meta_info *info = (set_meta_info *)item_get_meta(it);
@@ -826,7 +811,7 @@ ENGINE_ERROR_CODE set_elem_exist(const char *key, const uint32_t nkey,
     hash_item *it;
     ENGINE_ERROR_CODE ret;
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_set_item_find(key, nkey, DO_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) {
         set_meta_info *info = (set_meta_info *)item_get_meta(it);
@@ -858,7 +843,7 @@ ENGINE_ERROR_CODE set_elem_get(const char *key, const uint32_t nkey,
                                                         : UPD_SET_ELEM_DELETE));
     }
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     ret = do_set_item_find(key, nkey, DO_UPDATE, &it);
     if (ret == ENGINE_SUCCESS) {
         set_meta_info *info = (set_meta_info *)item_get_meta(it);
@@ -955,7 +940,7 @@ void set_elem_get_all(set_meta_info *info, elems_result_t *eresult)
                  * to-be-copied list.
                  */
                 for (elem = node->htab[i]; elem != NULL; elem = elem->next) {
-                    elem->refcount++;
+                    ELEM_REFCOUNT_INCR(elem);
                     eresult->elem_array[eresult->elem_count++] = elem;
                 }
             }
@@ -1052,7 +1037,7 @@ ENGINE_ERROR_CODE set_apply_item_link(void *engine, const char *key, const uint3
     logger->log(ITEM_APPLY_LOG_LEVEL, NULL, "set_apply_item_link. key=%.*s nkey=%u\n",
                 PRINT_NKEY(nkey), key, nkey);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     old_it = do_item_get(key, nkey, DONT_UPDATE);
     if (old_it) {
         /* Remove the old item first. */
@@ -1093,7 +1078,7 @@ ENGINE_ERROR_CODE set_apply_elem_insert(void *engine, hash_item *it,
     logger->log(ITEM_APPLY_LOG_LEVEL, NULL, "set_apply_elem_insert. key=%.*s nkey=%u\n",
                 PRINT_NKEY(it->nkey), key, it->nkey);
 
-    LOCK_CACHE();
+    LOCK_CACHE(it->khash);
     do {
         if (!item_is_valid(it)) {
             logger->log(EXTENSION_LOG_WARNING, NULL, "set_apply_elem_insert failed."
@@ -1137,7 +1122,7 @@ ENGINE_ERROR_CODE set_apply_elem_delete(void *engine, hash_item *it,
     logger->log(ITEM_APPLY_LOG_LEVEL, NULL, "set_apply_elem_delete. key=%.*s nkey=%u\n",
                 PRINT_NKEY(it->nkey), key, it->nkey);
 
-    LOCK_CACHE();
+    LOCK_CACHE(it->khash);
     do {
         if (!item_is_valid(it)) {
             logger->log(EXTENSION_LOG_WARNING, NULL, "set_apply_elem_delete failed."
@@ -160,6 +160,21 @@ static int check_configuration(struct engine_config *conf)
                 conf->scrub_count, MINIMUM_SCRUB_COUNT, MAXIMUM_SCRUB_COUNT);
         return -1;
     }
+    if (conf->cache_parts < MINIMUM_CACHE_PARTS ||
+        conf->cache_parts > MAXIMUM_CACHE_PARTS ||
+        (conf->cache_parts & (conf->cache_parts - 1)) != 0) {
+        logger->log(EXTENSION_LOG_WARNING, NULL,
+                "default engine: cache_parts(%u) is not a power of 2 in range(%u~%u).\n",
+                conf->cache_parts, MINIMUM_CACHE_PARTS, MAXIMUM_CACHE_PARTS);
+        return -1;
+    }
+    if (conf->hash_expand_step_usec < MINIMUM_EXPAND_STEP_USEC ||
+        conf->hash_expand_step_usec > MAXIMUM_EXPAND_STEP_USEC) {
+        logger->log(EXTENSION_LOG_WARNING, NULL,
+                "default engine: hash_expand_step_usec(%u) is out of range(%u~%u).\n",
+                conf->hash_expand_step_usec, MINIMUM_EXPAND_STEP_USEC, MAXIMUM_EXPAND_STEP_USEC);
+        return -1;
+    }
 #ifdef ENABLE_PERSISTENCE
     if (conf->use_persistence) {
         /* check data & logs directory path. */
@@ -214,6 +229,8 @@ initialize_configuration(struct default_engine *se, const char *cfg_str)
         { .key = "max_btree_size",    .datatype = DT_UINT32, .value.dt_uint32 = &se->config.max_btree_size },
         { .key = "max_element_bytes", .datatype = DT_UINT32, .value.dt_uint32 = &se->config.max_element_bytes },
         { .key = "scrub_count",       .datatype = DT_UINT32, .value.dt_uint32 = &se->config.scrub_count},
+        { .key = "cache_parts",       .datatype = DT_UINT32, .value.dt_uint32 = &se->config.cache_parts},
+        { .key = "hash_expand_step_usec", .datatype = DT_UINT32, .value.dt_uint32 = &se->config.hash_expand_step_usec},
 #ifdef ENABLE_PERSISTENCE
         { .key = "use_persistence",   .datatype = DT_BOOL,   .value.dt_bool = &se->config.use_persistence },
         { .key = "data_path",         .datatype = DT_STRING, .value.dt_string = &se->config.data_path },
@@ -266,6 +283,14 @@ default_initialize(ENGINE_HANDLE* handle, const char* config_str)
         se->info.engine_info.features[se->info.engine_info.num_features++].feature = ENGINE_FEATURE_CAS;
     }
 
+    /* cache partitions : initialized in item_init() */
+    se->cache_part_count = se->config.cache_parts;
+    se->cache_part_mask = se->config.cache_parts - 1;
+    se->cache_parts = calloc(se->cache_part_count, sizeof(struct cache_part));
+    if (se->cache_parts == NULL) {
+        return ENGINE_ENOMEM;
+    }
+
     ret = prefix_init(se);
     if (ret != ENGINE_SUCCESS) {
         return ret;
@@ -282,6 +307,9 @@ default_initialize(ENGINE_HANDLE* handle, const char* config_str)
     if (ret != ENGINE_SUCCESS) {
         return ret;
     }
+    if (assoc_thread_start() < 0) {
+        return ENGINE_FAILED;
+    }
 #ifdef ENABLE_PERSISTENCE
     if (se->config.use_persistence) {
         ret = cmdlog_mgr_init(se);
@@ -305,13 +333,13 @@ default_destroy(ENGINE_HANDLE* handle)
             cmdlog_mgr_final();
         }
 #endif
+        assoc_thread_stop();
         item_final(se);
         slabs_final(se);
         assoc_final(se);
         prefix_final(se);
-        pthread_mutex_destroy(&se->cache_lock);
-        pthread_mutex_destroy(&se->stats.lock);
         pthread_mutex_destroy(&se->slabs.lock);
+        free(se->cache_parts);
         free(se);
     }
 }
@@ -1189,6 +1217,12 @@ default_get_stats(ENGINE_HANDLE* handle, const void* cookie,
     else if (strncmp(stat_key, "dump", 4) == 0) {
         item_dump_stats(engine, add_stat, cookie);
     }
+    else if (strncmp(stat_key, "assoc", 5) == 0) {
+        assoc_stats(add_stat, cookie);
+    }
+    else if (strncmp(stat_key, "lru", 3) == 0) {
+        item_lru_stats(add_stat, cookie);
+    }
 #ifdef ENABLE_PERSISTENCE
     else if (strncmp(stat_key, "persistence", 11) == 0) {
         chkpt_persistence_stats(engine, add_stat, cookie);
@@ -1210,25 +1244,13 @@ static char *
 default_prefix_dump_stats(ENGINE_HANDLE* handle, const void* cookie,
     token_t *tokens, const size_t ntokens, int *length)
 {
-    struct default_engine* engine = get_handle(handle);
-    char *stats;
-
-    pthread_mutex_lock(&engine->cache_lock);
-    stats = prefix_dump_stats(tokens, ntokens, length);
-    pthread_mutex_unlock(&engine->cache_lock);
-    return stats;
+    return prefix_dump_stats(tokens, ntokens, length);
 }
 
 static int
 default_prefix_count(ENGINE_HANDLE* handle, const void* cookie)
 {
-    struct default_engine* engine = get_handle(handle);
-    int prefix_cnt;
-
-    pthread_mutex_lock(&engine->cache_lock);
-    prefix_cnt = prefix_count();
-    pthread_mutex_unlock(&engine->cache_lock);
-    return prefix_cnt;
+    return prefix_count();
 }
 
 /*
@@ -1397,7 +1419,7 @@ default_set_config(ENGINE_HANDLE* handle, const void* cookie,
 
     if (strcmp(config_key, "memlimit") == 0) {
         size_t new_maxbytes = *(size_t*)config_value;
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         if (new_maxbytes >= engine->config.sticky_limit) {
             ret = slabs_set_memlimit(new_maxbytes);
             if (ret == ENGINE_SUCCESS) {
@@ -1406,19 +1428,19 @@ default_set_config(ENGINE_HANDLE* handle, const void* cookie,
         } else {
             ret = ENGINE_EBADVALUE;
         }
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
 #ifdef ENABLE_STICKY_ITEM
     else if (strcmp(config_key, "sticky_limit") == 0) {
         size_t new_sticky_limit = *(size_t*)config_value;
-        pthread_mutex_lock(&engine->cache_lock);
-        if (new_sticky_limit >= engine->stats.sticky_bytes &&
+        LOCK_CACHE_ALL();
+        if (new_sticky_limit >= do_item_sticky_bytes() &&
             new_sticky_limit <= engine->config.maxbytes) {
             engine->config.sticky_limit = new_sticky_limit;
         } else {
             ret = ENGINE_EBADVALUE;
         }
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
 #endif
     else if (strcmp(config_key, "max_list_size") == 0) {
@@ -1428,13 +1450,13 @@ default_set_config(ENGINE_HANDLE* handle, const void* cookie,
             new_maxsize = MAXIMUM_MAX_COLL_SIZE;
         }
         /* It can be only increased */
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         if (new_maxsize > engine->config.max_list_size) {
             engine->config.max_list_size = new_maxsize;
         } else {
             ret = ENGINE_EBADVALUE;
         }
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
     else if (strcmp(config_key, "max_set_size") == 0) {
         int32_t new_maxsize = *(int32_t*)config_value;
@@ -1443,13 +1465,13 @@ default_set_config(ENGINE_HANDLE* handle, const void* cookie,
             new_maxsize = MAXIMUM_MAX_COLL_SIZE;
         }
         /* It can be only increased */
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         if (new_maxsize > engine->config.max_set_size) {
             engine->config.max_set_size = new_maxsize;
         } else {
             ret = ENGINE_EBADVALUE;
         }
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
     else if (strcmp(config_key, "max_map_size") == 0) {
         int32_t new_maxsize = *(int32_t*)config_value;
@@ -1458,13 +1480,13 @@ default_set_config(ENGINE_HANDLE* handle, const void* cookie,
             new_maxsize = MAXIMUM_MAX_COLL_SIZE;
         }
         /* It can be only increased */
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         if (new_maxsize > engine->config.max_map_size) {
             engine->config.max_map_size = new_maxsize;
         } else {
             ret = ENGINE_EBADVALUE;
         }
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
     else if (strcmp(config_key, "max_btree_size") == 0) {
         int32_t new_maxsize = *(int32_t*)config_value;
@@ -1473,69 +1495,69 @@ default_set_config(ENGINE_HANDLE* handle, const void* cookie,
             new_maxsize = MAXIMUM_MAX_COLL_SIZE;
         }
         /* It can be only increased */
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         if (new_maxsize > engine->config.max_btree_size) {
             engine->config.max_btree_size = new_maxsize;
         } else {
             ret = ENGINE_EBADVALUE;
         }
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
     else if (strcmp(config_key, "max_element_bytes") == 0) {
         uint32_t new_maxelembytes = *(uint32_t*)config_value;
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         if (new_maxelembytes >= MINIMUM_MAX_ELEMENT_BYTES &&
             new_maxelembytes <= MAXIMUM_MAX_ELEMENT_BYTES) {
             engine->config.max_element_bytes = new_maxelembytes;
         } else {
             ret = ENGINE_EBADVALUE;
         }
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
     else if (strcmp(config_key, "scrub_count") == 0) {
         uint32_t new_scrubcount = *(uint32_t*)config_value;
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         if (new_scrubcount >= MINIMUM_SCRUB_COUNT &&
             new_scrubcount <= MAXIMUM_SCRUB_COUNT) {
             engine->config.scrub_count = new_scrubcount;
         } else {
             ret = ENGINE_EBADVALUE;
         }
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
     else if (strcmp(config_key, "verbosity") == 0) {
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         engine->config.verbose = *(size_t*)config_value;
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
 #ifdef ENABLE_PERSISTENCE
     else if (engine->config.use_persistence) {
         if (strcmp(config_key, "chkpt_interval_pct_snapshot") == 0) {
             size_t new_chkpt_interval_pct_snapshot = *(size_t*)config_value;
-            pthread_mutex_lock(&engine->cache_lock);
+            LOCK_CACHE_ALL();
             if (new_chkpt_interval_pct_snapshot > 0 &&
                 new_chkpt_interval_pct_snapshot <= 1000) {
                 engine->config.chkpt_interval_pct_snapshot = new_chkpt_interval_pct_snapshot;
             } else {
                 ret = ENGINE_EBADVALUE;
             }
-            pthread_mutex_unlock(&engine->cache_lock);
+            UNLOCK_CACHE();
         }
         else if (strcmp(config_key, "chkpt_interval_min_logsize") == 0) {
             size_t new_chkpt_interval_min_logsize = *(size_t*)config_value;
-            pthread_mutex_lock(&engine->cache_lock);
+            LOCK_CACHE_ALL();
             if (new_chkpt_interval_min_logsize > 0) {
                 engine->config.chkpt_interval_min_logsize = new_chkpt_interval_min_logsize * 1024 * 1024;
             } else {
                 ret = ENGINE_EBADVALUE;
             }
-            pthread_mutex_unlock(&engine->cache_lock);
+            UNLOCK_CACHE();
         }
         else if (strcmp(config_key, "async_logging") == 0) {
             bool new_async_logging = *(bool*)config_value;
-            pthread_mutex_lock(&engine->cache_lock);
+            LOCK_CACHE_ALL();
             engine->config.async_logging = new_async_logging;
-            pthread_mutex_unlock(&engine->cache_lock);
+            UNLOCK_CACHE();
         }
     }
 #endif
@@ -1553,68 +1575,75 @@ default_get_config(ENGINE_HANDLE* handle, const void* cookie,
     ENGINE_ERROR_CODE ret = ENGINE_SUCCESS;
 
     if (strcmp(config_key, "memlimit") == 0) {
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         *(size_t*)config_value = engine->config.maxbytes;
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
 #ifdef ENABLE_STICKY_ITEM
     else if (strcmp(config_key, "sticky_limit") == 0) {
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         *(size_t*)config_value = engine->config.sticky_limit;
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
 #endif
     else if (strcmp(config_key, "max_list_size") == 0) {
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         *(uint32_t*)config_value = engine->config.max_list_size;
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
     else if (strcmp(config_key, "max_set_size") == 0) {
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         *(uint32_t*)config_value = engine->config.max_set_size;
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
     else if (strcmp(config_key, "max_map_size") == 0) {
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         *(uint32_t*)config_value = engine->config.max_map_size;
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
     else if (strcmp(config_key, "max_btree_size") == 0) {
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         *(uint32_t*)config_value = engine->config.max_btree_size;
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
     else if (strcmp(config_key, "max_element_bytes") == 0) {
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         *(uint32_t*)config_value = engine->config.max_element_bytes;
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
     else if (strcmp(config_key, "scrub_count") == 0) {
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         *(uint32_t*)config_value = engine->config.scrub_count;
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
+    }
+    else if (strcmp(config_key, "hash_expand_step_usec") == 0) {
+        *(uint32_t*)config_value = engine->config.hash_expand_step_usec;
+    }
+    else if (strcmp(config_key, "cache_parts") == 0) {
+        /* read-only : fixed at engine initialization */
+        *(uint32_t*)config_value = engine->cache_part_count;
     }
     else if (strcmp(config_key, "verbosity") == 0) {
-        pthread_mutex_lock(&engine->cache_lock);
+        LOCK_CACHE_ALL();
         *(size_t*)config_value = engine->config.verbose;
-        pthread_mutex_unlock(&engine->cache_lock);
+        UNLOCK_CACHE();
     }
 #ifdef ENABLE_PERSISTENCE
     else if (engine->config.use_persistence) {
         if (strcmp(config_key, "chkpt_interval_pct_snapshot") == 0) {
-            pthread_mutex_lock(&engine->cache_lock);
+            LOCK_CACHE_ALL();
             *(size_t*)config_value = engine->config.chkpt_interval_pct_snapshot;
-            pthread_mutex_unlock(&engine->cache_lock);
+            UNLOCK_CACHE();
         }
         else if (strcmp(config_key, "chkpt_interval_min_logsize") == 0) {
-            pthread_mutex_lock(&engine->cache_lock);
+            LOCK_CACHE_ALL();
             *(size_t*)config_value = engine->config.chkpt_interval_min_logsize/1024/1024;
-            pthread_mutex_unlock(&engine->cache_lock);
+            UNLOCK_CACHE();
         }
         else if (strcmp(config_key, "async_logging") == 0) {
-            pthread_mutex_lock(&engine->cache_lock);
+            LOCK_CACHE_ALL();
             *(bool*)config_value = engine->config.async_logging;
-            pthread_mutex_unlock(&engine->cache_lock);
+            UNLOCK_CACHE();
         }
     }
 #endif
@@ -2058,7 +2087,6 @@ create_instance(uint64_t interface, GET_SERVER_API get_server_api,
       .slabs = {
          .lock = PTHREAD_MUTEX_INITIALIZER
       },
-      .cache_lock = PTHREAD_MUTEX_INITIALIZER,
       .config = {
          .verbose = 0,
          .oldest_live = 0,
@@ -2078,6 +2106,8 @@ create_instance(uint64_t interface, GET_SERVER_API get_server_api,
          .max_btree_size = DEFAULT_MAX_BTREE_SIZE,
          .max_element_bytes = DEFAULT_MAX_ELEMENT_BYTES,
          .scrub_count = DEFAULT_SCRUB_COUNT,
+         .cache_parts = DEFAULT_CACHE_PARTS,
+         .hash_expand_step_usec = DEFAULT_EXPAND_STEP_USEC,
 #ifdef ENABLE_PERSISTENCE
          .use_persistence = false,
          .async_logging = false, /* default, sync logging */
@@ -2087,9 +2117,6 @@ create_instance(uint64_t interface, GET_SERVER_API get_server_api,
          .chkpt_interval_min_logsize = 256,
 #endif
        },
-      .stats = {
-         .lock = PTHREAD_MUTEX_INITIALIZER,
-      },
       .scrubber = {
          .lock = PTHREAD_MUTEX_INITIALIZER,
          .enabled = true,
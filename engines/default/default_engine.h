@@ -66,6 +66,8 @@ struct engine_config {
    uint32_t   max_btree_size;
    uint32_t   max_element_bytes;
    uint32_t   scrub_count;
+   uint32_t   cache_parts;
+   uint32_t   hash_expand_step_usec;
 #ifdef ENABLE_PERSISTENCE
    bool       use_persistence;
    bool       async_logging;
@@ -93,6 +95,25 @@ struct engine_stats {
    uint64_t total_items;
 };
 
+/**
+ * cache partition
+ *
+ * The cache layer (item_* and assoc_*) is split into cache partitions
+ * by the hash value of item key. The partition count is given by the
+ * "cache_parts" engine config. Each partition has its own cache lock,
+ * LRU lists and item statistics, so the partitions work like independent
+ * cache shards sharing the slab allocator. Since the partition id is
+ * taken from the lower bits of key hash, all items of an assoc hash
+ * bucket always belong to the same partition.
+ */
+
+struct cache_part {
+   pthread_mutex_t     lock;
+   struct items        items;
+   struct engine_stats stats;
+   struct item_retire  retire;
+};
+
 /**
  * scrubber
  */
@@ -149,16 +170,16 @@ struct default_engine {
    struct prefix prefix;
    struct assoc assoc;
    struct slabs slabs;
-   struct items items;
 
    /**
-    * The cache layer (item_* and assoc_*) is currently protected by
-    * this single mutex
+    * The cache layer (item_* and assoc_*) is protected by
+    * the per-partition cache locks.
     */
-   pthread_mutex_t cache_lock;
+   struct cache_part *cache_parts;
+   uint32_t cache_part_count;
+   uint32_t cache_part_mask;
 
    struct engine_config config;
-   struct engine_stats stats;
    struct engine_scrubber scrubber;
    struct engine_dumper dumper;
    union {
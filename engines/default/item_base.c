@@ -29,6 +29,7 @@
 #include <assert.h>
 #include <string.h>
 #include <time.h>
+#include <sched.h>
 #include <sys/time.h> /* gettimeofday() */
 #include <pthread.h>
 #include "default_engine.h"
@@ -37,18 +38,10 @@
 
 static struct default_engine *engine=NULL;
 static struct engine_config *config=NULL; // engine config
-static struct items         *itemsp=NULL;
-static struct engine_stats  *statsp=NULL;
 static SERVER_STAT_API      *svstat=NULL; // server stat api
 static SERVER_CORE_API      *svcore=NULL; // server core api
 static EXTENSION_LOGGER_DESCRIPTOR *logger;
 
-/* We only reposition items in the LRU queue if they haven't been repositioned
- * in this many seconds. That saves us from churning on frequently-accessed
- * items.
- */
-#define ITEM_UPDATE_INTERVAL 60
-
 /* How long an object can reasonably be assumed to be locked before
  * harvesting it on a low memory condition.
  */
@@ -74,29 +67,260 @@ static pthread_t       coll_del_tid; /* thread id */
 static bool            coll_del_sleep = false;
 static volatile bool   coll_del_thread_running = false;
 
+/* LRU maintainer thread */
+static pthread_mutex_t lru_maint_lock;
+static pthread_cond_t  lru_maint_cond;
+static pthread_t       lru_maint_tid; /* thread id */
+static bool            lru_maint_sleep = false;
+static volatile bool   lru_maint_thread_running = false;
+
+/* LRU bump buffers
+ * The worker threads queue the items activated in the COLD segment
+ * to their own buffers, and the LRU maintainer moves them to WARM
+ * in batches. The queued items are pinned by a reference.
+ */
+#define LRU_BUMP_BUF_COUNT 256 /* max threads having a bump buffer */
+#define LRU_BUMP_BUF_SIZE  64  /* max bumps queued in a buffer */
+#define LRU_BUMP_BUF_NONE  -1  /* not yet registered */
+#define LRU_BUMP_BUF_FULL  -2  /* no buffer available */
+
+struct lru_bump_buf {
+    pthread_mutex_t lock;
+    uint32_t        count;
+    hash_item      *items[LRU_BUMP_BUF_SIZE];
+    uint64_t        queued;  /* # of queued bumps */
+    uint64_t        dropped; /* # of bumps dropped on a full or busy buffer */
+};
+
+struct lru_bump_stats {
+    uint64_t batches;     /* # of drained batches */
+    uint64_t batch_items; /* # of items in the drained batches */
+    uint64_t batch_max;   /* max # of items in a batch */
+    uint64_t applied;     /* # of items moved to WARM */
+    uint64_t maint_moves; /* # of items moved by the LRU maintainer */
+};
+
+static struct lru_bump_buf  *lru_bump_bufs[LRU_BUMP_BUF_COUNT];
+static uint32_t              lru_bump_buf_count = 0;
+static __thread int          lru_bump_buf_id = LRU_BUMP_BUF_NONE;
+static struct lru_bump_stats lru_bump_stats; /* changed only by the LRU maintainer */
+
+/* element locks */
+#define ELEM_LOCK_COUNT 1024 /* must be a power of 2 */
+static pthread_mutex_t elem_locks[ELEM_LOCK_COUNT];
+
+/* lock-free read sections */
+#define READ_SLOT_COUNT 256 /* max threads using lock-free read path */
+#define READ_SLOT_NONE  -1  /* not yet registered */
+#define READ_SLOT_FULL  -2  /* no slot available */
+
+struct read_slot {
+    uint64_t epoch; /* epoch of the read section, 0 if not in it */
+} __attribute__((aligned(64)));
+
+static struct read_slot read_slots[READ_SLOT_COUNT];
+static uint32_t         read_slot_count = 0;
+static uint64_t         read_epoch = 1; /* global epoch */
+static __thread int     read_slot_id = READ_SLOT_NONE;
+
+/* The cache partition locked by the current thread.
+ * -1 means no partition, MAXIMUM_CACHE_PARTS means all partitions.
+ */
+#define CACHE_PART_NONE -1
+#define CACHE_PART_ALL  MAXIMUM_CACHE_PARTS
+static __thread int cache_part_held = CACHE_PART_NONE;
+static __thread int cache_part_hint = 0; /* See LOCK_CACHE_ANY() */
+
 /*
- * Static functions
+ * Cache Lock
+ */
+void LOCK_CACHE(const uint32_t hash)
+{
+    int pid = hash & engine->cache_part_mask;
+    assert(cache_part_held == CACHE_PART_NONE);
+    pthread_mutex_lock(&engine->cache_parts[pid].lock);
+    cache_part_held = pid;
+}
+
+/* Lock any cache partition. It's used by the operations
+ * that are not bound to a key such as element allocation.
+ */
+void LOCK_CACHE_ANY(void)
+{
+    int pid = cache_part_hint;
+    assert(cache_part_held == CACHE_PART_NONE);
+    for (int i = 0; i < engine->cache_part_count; i++) {
+        if (pthread_mutex_trylock(&engine->cache_parts[pid].lock) == 0) {
+            cache_part_held = cache_part_hint = pid;
+            return;
+        }
+        pid = (pid + 1) & engine->cache_part_mask;
+    }
+    pthread_mutex_lock(&engine->cache_parts[pid].lock);
+    cache_part_held = pid;
+}
+
+/* Lock all cache partitions in the partition order.
+ * It's used by the operations on the whole cache such as
+ * flush, stats, scan and hash table expansion.
+ */
+void LOCK_CACHE_ALL(void)
+{
+    assert(cache_part_held == CACHE_PART_NONE);
+    for (int i = 0; i < engine->cache_part_count; i++) {
+        pthread_mutex_lock(&engine->cache_parts[i].lock);
+    }
+    cache_part_held = CACHE_PART_ALL;
+}
+
+void UNLOCK_CACHE(void)
+{
+    assert(cache_part_held != CACHE_PART_NONE);
+    if (cache_part_held == CACHE_PART_ALL) {
+        for (int i = engine->cache_part_count-1; i >= 0; i--) {
+            pthread_mutex_unlock(&engine->cache_parts[i].lock);
+        }
+    } else {
+        pthread_mutex_unlock(&engine->cache_parts[cache_part_held].lock);
+    }
+    cache_part_held = CACHE_PART_NONE;
+}
+
+/*
+ * Element Lock
+ *
+ * Elements are released without the cache lock. So, the element lock
+ * serializes the last reference release and the element unlink, that is
+ *   - release: decrement refcount, and free the element if it's unlinked.
+ *   - unlink:  mark the element unlinked, and free it if refcount is 0.
  */
-static inline void LOCK_CACHE(void)
+void LOCK_ELEM(const void *elem)
 {
-    pthread_mutex_lock(&engine->cache_lock);
+    pthread_mutex_lock(&elem_locks[((uintptr_t)elem >> 6) & (ELEM_LOCK_COUNT-1)]);
 }
 
-static inline void UNLOCK_CACHE(void)
+void UNLOCK_ELEM(const void *elem)
 {
-    pthread_mutex_unlock(&engine->cache_lock);
+    pthread_mutex_unlock(&elem_locks[((uintptr_t)elem >> 6) & (ELEM_LOCK_COUNT-1)]);
 }
 
+/*
+ * Lock-free Read Section
+ *
+ * The simple key-value items are found and referenced in the read section
+ * without the cache lock. See item_get_lockfree().
+ * Each reader announces the global epoch in its slot while in the read
+ * section, and the global epoch is advanced only if all the readers in the
+ * read section have announced it. So, the memory retired in an epoch
+ * can be freed after the global epoch is advanced twice from it.
+ * Note that the readers must not wait for any lock in the read section.
+ */
+bool item_read_enter(void)
+{
+    if (read_slot_id < 0) {
+        if (read_slot_id == READ_SLOT_FULL) {
+            return false;
+        }
+        uint32_t id = __sync_fetch_and_add(&read_slot_count, 1);
+        if (id >= READ_SLOT_COUNT) {
+            read_slot_id = READ_SLOT_FULL;
+            return false;
+        }
+        read_slot_id = id;
+    }
+    __atomic_store_n(&read_slots[read_slot_id].epoch,
+                     __atomic_load_n(&read_epoch, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return true;
+}
+
+void item_read_exit(void)
+{
+    assert(read_slot_id >= 0);
+    __atomic_store_n(&read_slots[read_slot_id].epoch, 0, __ATOMIC_RELEASE);
+}
+
+static void read_epoch_advance(uint64_t epoch)
+{
+    uint32_t count = __atomic_load_n(&read_slot_count, __ATOMIC_ACQUIRE);
+    if (count > READ_SLOT_COUNT) {
+        count = READ_SLOT_COUNT;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t slot_epoch = __atomic_load_n(&read_slots[i].epoch, __ATOMIC_ACQUIRE);
+        if (slot_epoch != 0 && slot_epoch != epoch) {
+            return; /* a reader is still in the older epoch */
+        }
+    }
+    (void)__sync_bool_compare_and_swap(&read_epoch, epoch, epoch+1);
+}
+
+/* Get the current epoch to retire the memory unlinked before. */
+static inline uint64_t read_epoch_retire(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return __atomic_load_n(&read_epoch, __ATOMIC_RELAXED);
+}
+
+/* Check if no reader can see the memory retired in the given epoch. */
+static bool read_epoch_passed(uint64_t epoch)
+{
+    uint64_t curr_epoch;
+    for (int i = 0; i < 2; i++) {
+        curr_epoch = __atomic_load_n(&read_epoch, __ATOMIC_ACQUIRE);
+        if (curr_epoch >= epoch + 2) {
+            return true;
+        }
+        read_epoch_advance(curr_epoch);
+    }
+    return __atomic_load_n(&read_epoch, __ATOMIC_ACQUIRE) >= epoch + 2;
+}
+
+/* Wait for the readers that might see the memory unlinked before.
+ * It's used to free the memory that is rarely freed.
+ */
+void item_read_synchronize(void)
+{
+    uint64_t epoch = read_epoch_retire();
+    while (!read_epoch_passed(epoch)) {
+        sched_yield();
+    }
+}
+
+/* the cache partition of the given item */
+static inline struct cache_part *ITEM_CACHE_PART(const hash_item *it)
+{
+    return &engine->cache_parts[it->khash & engine->cache_part_mask];
+}
+
+/* the cache partition locked by the current thread */
+static inline struct cache_part *CURR_CACHE_PART(void)
+{
+    assert(cache_part_held != CACHE_PART_NONE);
+    if (cache_part_held == CACHE_PART_ALL) {
+        return &engine->cache_parts[0];
+    }
+    return &engine->cache_parts[cache_part_held];
+}
+
+/*
+ * Static functions
+ */
+
 #define ITEM_REFCOUNT_FULL 65535
 #define ITEM_REFCOUNT_MOVE 32768
+#define ITEM_REFCOUNT_DEAD ITEM_REFCOUNT_FULL /* being freed */
 
+/* The item refcount is atomically changed since the lock-free readers
+ * reference the items without the cache lock. The refchunk is changed
+ * only with the cache lock held.
+ */
 //static inline void ITEM_REFCOUNT_INCR(hash_item *it)
 void ITEM_REFCOUNT_INCR(hash_item *it)
 {
-    it->refcount++;
-    if (it->refcount == ITEM_REFCOUNT_FULL) {
+    if (__sync_add_and_fetch(&it->refcount, 1) == ITEM_REFCOUNT_FULL) {
         it->refchunk += 1;
-        it->refcount -= ITEM_REFCOUNT_MOVE;
+        (void)__sync_sub_and_fetch(&it->refcount, ITEM_REFCOUNT_MOVE);
         assert(it->refchunk != 0); /* overflow */
     }
 }
@@ -104,11 +328,34 @@ void ITEM_REFCOUNT_INCR(hash_item *it)
 //static inline void ITEM_REFCOUNT_DECR(hash_item *it)
 void ITEM_REFCOUNT_DECR(hash_item *it)
 {
-    it->refcount--;
-    if (it->refcount == 0 && it->refchunk > 0) {
+    if (__sync_sub_and_fetch(&it->refcount, 1) == 0 && it->refchunk > 0) {
         it->refchunk -= 1;
-        it->refcount = ITEM_REFCOUNT_MOVE;
+        (void)__sync_add_and_fetch(&it->refcount, ITEM_REFCOUNT_MOVE);
+    }
+}
+
+/* Reference the item without the cache lock.
+ * It fails if the item is being freed or has too many references.
+ */
+static inline bool ITEM_REFCOUNT_TRYINCR(hash_item *it)
+{
+    uint16_t refcount = __atomic_load_n(&it->refcount, __ATOMIC_RELAXED);
+    while (refcount < ITEM_REFCOUNT_MOVE) {
+        if (__atomic_compare_exchange_n(&it->refcount, &refcount, refcount+1, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            return true;
+        }
     }
+    return false;
+}
+
+/* Mark the unreferenced item as being freed.
+ * If it fails, a lock-free reader has referenced the item
+ * and the item will be freed when the reader releases it.
+ */
+static inline bool ITEM_REFCOUNT_KILL(hash_item *it)
+{
+    return __sync_bool_compare_and_swap(&it->refcount, 0, ITEM_REFCOUNT_DEAD);
 }
 
 static inline uint32_t _hash_item_size(const hash_item *item)
@@ -163,11 +410,12 @@ static inline void UNLOCK_STATS(void)
     //pthread_mutex_unlock(&statsp->lock);
 }
 
-static inline void do_item_stat_reclaim(const unsigned int lruid)
+static inline void do_item_stat_reclaim(const unsigned int lruid, hash_item *it)
 {
-    itemsp->itemstats[lruid].reclaimed++;
+    struct cache_part *cp = ITEM_CACHE_PART(it);
+    cp->items.itemstats[lruid].reclaimed++;
     LOCK_STATS();
-    statsp->reclaimed++;
+    cp->stats.reclaimed++;
     UNLOCK_STATS();
 }
 
@@ -175,13 +423,14 @@ static inline void do_item_stat_evict(const unsigned int lruid,
                                       rel_time_t current_time,
                                       hash_item *it, const void *cookie)
 {
-    itemsp->itemstats[lruid].evicted++;
-    itemsp->itemstats[lruid].evicted_time = current_time - it->time;
+    struct cache_part *cp = ITEM_CACHE_PART(it);
+    cp->items.itemstats[lruid].evicted++;
+    cp->items.itemstats[lruid].evicted_time = current_time - it->time;
     if (it->exptime > 0) {
-        itemsp->itemstats[lruid].evicted_nonzero++;
+        cp->items.itemstats[lruid].evicted_nonzero++;
     }
     LOCK_STATS();
-    statsp->evictions++;
+    cp->stats.evictions++;
     UNLOCK_STATS();
     if (cookie != NULL) {
         svstat->evicting(cookie, item_get_key(it), it->nkey);
@@ -190,14 +439,16 @@ static inline void do_item_stat_evict(const unsigned int lruid,
 
 static inline void do_item_stat_outofmemory(const unsigned int lruid)
 {
-    itemsp->itemstats[lruid].outofmemory++;
+    struct cache_part *cp = CURR_CACHE_PART();
+    cp->items.itemstats[lruid].outofmemory++;
     LOCK_STATS();
-    statsp->outofmemorys++;
+    cp->stats.outofmemorys++;
     UNLOCK_STATS();
 }
 
 static inline void do_item_stat_link(hash_item *it, size_t stotal)
 {
+    struct engine_stats *statsp = &ITEM_CACHE_PART(it)->stats;
     LOCK_STATS();
 #ifdef ENABLE_STICKY_ITEM
     if (IS_STICKY_EXPTIME(it->exptime)) {
@@ -213,6 +464,7 @@ static inline void do_item_stat_link(hash_item *it, size_t stotal)
 
 static inline void do_item_stat_unlink(hash_item *it, size_t stotal)
 {
+    struct engine_stats *statsp = &ITEM_CACHE_PART(it)->stats;
     LOCK_STATS();
 #ifdef ENABLE_STICKY_ITEM
     if (IS_STICKY_EXPTIME(it->exptime)) {
@@ -227,6 +479,7 @@ static inline void do_item_stat_unlink(hash_item *it, size_t stotal)
 
 static inline void do_item_stat_replace(hash_item *old_it, hash_item *new_it)
 {
+    struct engine_stats *statsp = &ITEM_CACHE_PART(new_it)->stats;
     prefix_t *pt = new_it->pfxptr;
     size_t old_stotal = ITEM_stotal(old_it);
     size_t new_stotal = ITEM_stotal(new_it);
@@ -254,6 +507,7 @@ static inline void do_item_stat_replace(hash_item *old_it, hash_item *new_it)
 
 static inline void do_item_stat_bytes_incr(hash_item *it, size_t stotal)
 {
+    struct engine_stats *statsp = &ITEM_CACHE_PART(it)->stats;
     LOCK_STATS();
 #ifdef ENABLE_STICKY_ITEM
     if (IS_STICKY_EXPTIME(it->exptime)) {
@@ -266,6 +520,7 @@ static inline void do_item_stat_bytes_incr(hash_item *it, size_t stotal)
 
 static inline void do_item_stat_bytes_decr(hash_item *it, size_t stotal)
 {
+    struct engine_stats *statsp = &ITEM_CACHE_PART(it)->stats;
     LOCK_STATS();
 #ifdef ENABLE_STICKY_ITEM
     if (IS_STICKY_EXPTIME(it->exptime)) {
@@ -279,27 +534,42 @@ static inline void do_item_stat_bytes_decr(hash_item *it, size_t stotal)
 //static inline void do_item_stat_get(ADD_STAT add_stat, const void *cookie)
 void do_item_stat_get(ADD_STAT add_stat, const void *cookie)
 {
+    struct engine_stats sum;
     char val[128];
     int len;
 
+    /* aggregate the stats of all cache partitions */
+    memset(&sum, 0, sizeof(sum));
     LOCK_STATS();
-    len = sprintf(val, "%"PRIu64, statsp->reclaimed);
+    for (int i = 0; i < engine->cache_part_count; i++) {
+        struct engine_stats *statsp = &engine->cache_parts[i].stats;
+        sum.reclaimed += statsp->reclaimed;
+        sum.evictions += statsp->evictions;
+        sum.outofmemorys += statsp->outofmemorys;
+        sum.sticky_items += statsp->sticky_items;
+        sum.curr_items += statsp->curr_items;
+        sum.total_items += statsp->total_items;
+        sum.sticky_bytes += statsp->sticky_bytes;
+        sum.curr_bytes += statsp->curr_bytes;
+    }
+    UNLOCK_STATS();
+
+    len = sprintf(val, "%"PRIu64, sum.reclaimed);
     add_stat("reclaimed", 9, val, len, cookie);
-    len = sprintf(val, "%"PRIu64, (uint64_t)statsp->evictions);
+    len = sprintf(val, "%"PRIu64, (uint64_t)sum.evictions);
     add_stat("evictions", 9, val, len, cookie);
-    len = sprintf(val, "%"PRIu64, (uint64_t)statsp->outofmemorys);
+    len = sprintf(val, "%"PRIu64, (uint64_t)sum.outofmemorys);
     add_stat("outofmemorys", 12, val, len, cookie);
-    len = sprintf(val, "%"PRIu64, (uint64_t)statsp->sticky_items);
+    len = sprintf(val, "%"PRIu64, (uint64_t)sum.sticky_items);
     add_stat("sticky_items", 12, val, len, cookie);
-    len = sprintf(val, "%"PRIu64, (uint64_t)statsp->curr_items);
+    len = sprintf(val, "%"PRIu64, (uint64_t)sum.curr_items);
     add_stat("curr_items", 10, val, len, cookie);
-    len = sprintf(val, "%"PRIu64, (uint64_t)statsp->total_items);
+    len = sprintf(val, "%"PRIu64, (uint64_t)sum.total_items);
     add_stat("total_items", 11, val, len, cookie);
-    len = sprintf(val, "%"PRIu64, (uint64_t)statsp->sticky_bytes);
+    len = sprintf(val, "%"PRIu64, (uint64_t)sum.sticky_bytes);
     add_stat("sticky_bytes", 12, val, len, cookie);
-    len = sprintf(val, "%"PRIu64, (uint64_t)statsp->curr_bytes);
+    len = sprintf(val, "%"PRIu64, (uint64_t)sum.curr_bytes);
     add_stat("bytes", 5, val, len, cookie);
-    UNLOCK_STATS();
 
     len = sprintf(val, "%"PRIu64, (uint64_t)config->sticky_limit);
     add_stat("sticky_limit", 12, val, len, cookie);
@@ -310,23 +580,39 @@ void do_item_stat_get(ADD_STAT add_stat, const void *cookie)
 //static inline void do_item_stat_reset(void)
 void do_item_stat_reset(void)
 {
-    /* reset engine->items.itemstats */
-    memset(itemsp->itemstats, 0, sizeof(itemsp->itemstats));
+    for (int i = 0; i < engine->cache_part_count; i++) {
+        struct cache_part *cp = &engine->cache_parts[i];
 
-    /* reset engine->stats */
-    LOCK_STATS();
-    statsp->evictions = 0;
-    statsp->reclaimed = 0;
-    statsp->outofmemorys = 0;
-    statsp->total_items = 0;
-    UNLOCK_STATS();
+        /* reset items.itemstats */
+        memset(cp->items.itemstats, 0, sizeof(cp->items.itemstats));
+
+        /* reset stats */
+        LOCK_STATS();
+        cp->stats.evictions = 0;
+        cp->stats.reclaimed = 0;
+        cp->stats.outofmemorys = 0;
+        cp->stats.total_items = 0;
+        UNLOCK_STATS();
+    }
 }
 
 #ifdef ENABLE_STICKY_ITEM
+uint64_t do_item_sticky_bytes(void)
+{
+    /* It can be called with a cache partition lock.
+     * So, the sum of sticky bytes might be slightly stale.
+     */
+    uint64_t sticky_bytes = 0;
+    for (int i = 0; i < engine->cache_part_count; i++) {
+        sticky_bytes += engine->cache_parts[i].stats.sticky_bytes;
+    }
+    return sticky_bytes;
+}
+
 //static inline bool do_item_sticky_overflowed(void)
 bool do_item_sticky_overflowed(void)
 {
-    if (statsp->sticky_bytes < config->sticky_limit) {
+    if (do_item_sticky_bytes() < config->sticky_limit) {
         return false;
     }
     return true;
@@ -375,11 +661,32 @@ static inline uint32_t GEN_ITEM_KEY_HASH(const char *key, const uint32_t nkey)
         return svcore->hash(key, nkey, 0);
     }
 }
-/* Get the next CAS id for a new item. */
-static uint64_t get_cas_id(void)
+
+uint32_t item_key_hash(const void *key, const uint32_t nkey)
 {
-    static uint64_t cas_id = 0;
-    return ++cas_id;
+    return GEN_ITEM_KEY_HASH(key, nkey);
+}
+
+/* CAS ids are reserved from the global CAS id in blocks by each thread,
+ * so that the threads storing items don't contend on the global CAS id.
+ */
+#define CAS_ID_BLOCK_SIZE 1024
+
+static uint64_t          cas_id_global = 0;
+static __thread uint64_t cas_id_next = 0; /* next CAS id in the block */
+static __thread uint64_t cas_id_end = 0;  /* end of the block */
+
+/* Get the next CAS id for a new item.
+ * The CAS id is larger than old_cas, the CAS id of the item being replaced.
+ * A new block always has larger CAS ids than all the reserved blocks.
+ */
+static uint64_t get_cas_id(uint64_t old_cas)
+{
+    if (cas_id_next >= cas_id_end || cas_id_next <= old_cas) {
+        cas_id_next = __sync_fetch_and_add(&cas_id_global, CAS_ID_BLOCK_SIZE) + 1;
+        cas_id_end = cas_id_next + CAS_ID_BLOCK_SIZE;
+    }
+    return cas_id_next++;
 }
 
 /* Enable this for reference-count debugging. */
@@ -450,19 +757,154 @@ static uint32_t do_coll_elem_delete_with_count(hash_item *it, uint32_t count)
     return ndeleted;
 }
 
-static void item_link_q(hash_item *it)
+/*
+ * Segmented LRU
+ *
+ * The LRU list of each lruid is split into HOT, WARM and COLD segments.
+ * The new items are linked to the HOT segment. The readers only set
+ * the access bits of the item, and the LRU maintainer thread moves
+ * the tail items of HOT and WARM segments: the active ones to WARM,
+ * and the others to COLD. The items are evicted from the COLD segment.
+ * The item time is reset when it enters a segment, so that the items
+ * of each segment are kept in decreasing time order.
+ */
+#define LRU_HOT_PERCENT  20  /* max share of the HOT segment */
+#define LRU_WARM_PERCENT 40  /* max share of the WARM segment */
+#define LRU_MAINT_MOVES  256 /* max moves of a partition in a maintainer pass */
+#define LRU_FEED_TRIES   16  /* max HOT tail pulls before forced demotion */
+
+static inline int item_lru_id(const hash_item *it)
 {
-    hash_item **head, **tail;
     assert(it->slabs_clsid <= POWER_LARGEST);
-
 #ifdef USE_SINGLE_LRU_LIST
-    int clsid = 1;
+    return 1;
 #else
-    int clsid = it->slabs_clsid;
     if (IS_COLL_ITEM(it) || ITEM_ntotal(it) <= MAX_SM_VALUE_LEN) {
-        clsid = LRU_CLSID_FOR_SMALL;
+        return LRU_CLSID_FOR_SMALL;
     }
+    return it->slabs_clsid;
 #endif
+}
+
+/* The access bits are set by the readers without the cache lock.
+ * So, the LRU flag is always changed atomically.
+ */
+static inline void ITEM_LRU_FLAG_UPDATE(hash_item *it, uint8_t clear, uint8_t set)
+{
+    uint8_t flag = __atomic_load_n(&it->lruflag, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&it->lruflag, &flag, (flag & ~clear) | set,
+                                        false, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static inline uint8_t ITEM_LRU_SEGMENT_OF(const hash_item *it)
+{
+    return __atomic_load_n(&it->lruflag, __ATOMIC_RELAXED) & ITEM_LRU_SEGMENT;
+}
+
+static inline bool ITEM_LRU_IS_ACTIVE(const hash_item *it)
+{
+    return (__atomic_load_n(&it->lruflag, __ATOMIC_RELAXED) & ITEM_LRU_ACTIVE) != 0;
+}
+
+/* Mark the item as read. The first read sets the fetched bit,
+ * and the next one sets the active bit. It needs no cache lock.
+ * true is returned if the item has become active.
+ */
+static inline bool item_lru_touch(hash_item *it)
+{
+    uint8_t flag = __atomic_load_n(&it->lruflag, __ATOMIC_RELAXED);
+    if ((flag & ITEM_LRU_FETCHED) == 0) {
+        (void)__atomic_fetch_or(&it->lruflag, ITEM_LRU_FETCHED, __ATOMIC_RELAXED);
+        return false;
+    }
+    if ((flag & ITEM_LRU_ACTIVE) == 0) {
+        (void)__atomic_fetch_or(&it->lruflag, ITEM_LRU_ACTIVE, __ATOMIC_RELAXED);
+        return true;
+    }
+    return false;
+}
+
+/* Get the bump buffer of the current thread. */
+static struct lru_bump_buf *lru_bump_buf_get(void)
+{
+    if (lru_bump_buf_id < 0) {
+        if (lru_bump_buf_id == LRU_BUMP_BUF_FULL) {
+            return NULL;
+        }
+        uint32_t id = __sync_fetch_and_add(&lru_bump_buf_count, 1);
+        if (id >= LRU_BUMP_BUF_COUNT) {
+            lru_bump_buf_id = LRU_BUMP_BUF_FULL;
+            return NULL;
+        }
+        struct lru_bump_buf *bb = calloc(1, sizeof(struct lru_bump_buf));
+        if (bb == NULL) {
+            lru_bump_buf_id = LRU_BUMP_BUF_FULL;
+            return NULL;
+        }
+        pthread_mutex_init(&bb->lock, NULL);
+        __atomic_store_n(&lru_bump_bufs[id], bb, __ATOMIC_RELEASE);
+        lru_bump_buf_id = id;
+    }
+    return lru_bump_bufs[lru_bump_buf_id];
+}
+
+static void lru_maint_thread_wakeup(void);
+
+/* Queue the item activated in the COLD segment to the bump buffer.
+ * It can be called with or without the cache lock.
+ * The bump is dropped if the buffer is full or being drained,
+ * and then the item is rescued when it reaches the COLD tail.
+ */
+static void item_lru_bump(hash_item *it)
+{
+    struct lru_bump_buf *bb;
+    bool wakeup = false;
+
+    if ((bb = lru_bump_buf_get()) == NULL) {
+        return;
+    }
+    if (pthread_mutex_trylock(&bb->lock) != 0) {
+        (void)__atomic_fetch_add(&bb->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    if (bb->count < LRU_BUMP_BUF_SIZE && ITEM_REFCOUNT_TRYINCR(it)) {
+        bb->items[bb->count++] = it;
+        __atomic_store_n(&bb->queued, bb->queued + 1, __ATOMIC_RELAXED);
+        wakeup = (bb->count == LRU_BUMP_BUF_SIZE / 2);
+    } else {
+        (void)__atomic_fetch_add(&bb->dropped, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&bb->lock);
+
+    if (wakeup) {
+        lru_maint_thread_wakeup();
+    }
+}
+
+/* Mark the item as read, and queue the bump if it's activated in COLD.
+ * true is returned if the item has become active.
+ */
+static inline bool item_lru_access(hash_item *it)
+{
+    if (!item_lru_touch(it)) {
+        return false;
+    }
+#ifdef ENABLE_STICKY_ITEM
+    if (IS_STICKY_EXPTIME(it->exptime)) {
+        return true;
+    }
+#endif
+    if (ITEM_LRU_SEGMENT_OF(it) == ITEM_LRU_COLD) {
+        item_lru_bump(it);
+    }
+    return true;
+}
+
+static void item_link_q_seg(hash_item *it, const uint8_t seg)
+{
+    struct items *itemsp = &ITEM_CACHE_PART(it)->items;
+    hash_item **head, **tail;
+    int clsid = item_lru_id(it);
 
 #ifdef ENABLE_STICKY_ITEM
     if (IS_STICKY_EXPTIME(it->exptime)) {
@@ -471,16 +913,27 @@ static void item_link_q(hash_item *it)
         itemsp->sticky_sizes[clsid]++;
     } else {
 #endif
-        head = &itemsp->heads[clsid];
-        tail = &itemsp->tails[clsid];
         itemsp->sizes[clsid]++;
-        if (it->exptime > 0) { /* expirable item */
-            if (itemsp->lowMK[clsid] == NULL) {
-                /* set lowMK and curMK pointer in LRU */
-                itemsp->lowMK[clsid] = it;
-                itemsp->curMK[clsid] = it;
+        if (seg == ITEM_LRU_HOT) {
+            head = &itemsp->hot_heads[clsid];
+            tail = &itemsp->hot_tails[clsid];
+            itemsp->hot_sizes[clsid]++;
+        } else if (seg == ITEM_LRU_WARM) {
+            head = &itemsp->warm_heads[clsid];
+            tail = &itemsp->warm_tails[clsid];
+            itemsp->warm_sizes[clsid]++;
+        } else {
+            head = &itemsp->heads[clsid];
+            tail = &itemsp->tails[clsid];
+            if (it->exptime > 0) { /* expirable item */
+                if (itemsp->lowMK[clsid] == NULL) {
+                    /* set lowMK and curMK pointer in LRU */
+                    itemsp->lowMK[clsid] = it;
+                    itemsp->curMK[clsid] = it;
+                }
             }
         }
+        ITEM_LRU_FLAG_UPDATE(it, ITEM_LRU_SEGMENT, seg);
 #ifdef ENABLE_STICKY_ITEM
     }
 #endif
@@ -494,18 +947,16 @@ static void item_link_q(hash_item *it)
     return;
 }
 
+static void item_link_q(hash_item *it)
+{
+    item_link_q_seg(it, ITEM_LRU_HOT);
+}
+
 static void item_unlink_q(hash_item *it)
 {
+    struct items *itemsp = &ITEM_CACHE_PART(it)->items;
     hash_item **head, **tail;
-    assert(it->slabs_clsid <= POWER_LARGEST);
-#ifdef USE_SINGLE_LRU_LIST
-    int clsid = 1;
-#else
-    int clsid = it->slabs_clsid;
-    if (IS_COLL_ITEM(it) || ITEM_ntotal(it) <= MAX_SM_VALUE_LEN) {
-        clsid = LRU_CLSID_FOR_SMALL;
-    }
-#endif
+    int clsid = item_lru_id(it);
 
     if (it->prev == it && it->next == it) { /* special meaning: unlinked from LRU */
         return; /* Already unlinked from LRU list */
@@ -521,16 +972,29 @@ static void item_unlink_q(hash_item *it)
             itemsp->sticky_curMK[clsid] = it->prev;
     } else {
 #endif
-        head = &itemsp->heads[clsid];
-        tail = &itemsp->tails[clsid];
         itemsp->sizes[clsid]--;
-        /* move lowMK, curMK pointer in LRU */
-        if (itemsp->lowMK[clsid] == it)
-            itemsp->lowMK[clsid] = it->prev;
-        if (itemsp->curMK[clsid] == it) {
-            itemsp->curMK[clsid] = it->prev;
-            if (itemsp->curMK[clsid] == NULL)
-                itemsp->curMK[clsid] = itemsp->lowMK[clsid];
+        switch (ITEM_LRU_SEGMENT_OF(it)) {
+          case ITEM_LRU_HOT:
+            head = &itemsp->hot_heads[clsid];
+            tail = &itemsp->hot_tails[clsid];
+            itemsp->hot_sizes[clsid]--;
+            break;
+          case ITEM_LRU_WARM:
+            head = &itemsp->warm_heads[clsid];
+            tail = &itemsp->warm_tails[clsid];
+            itemsp->warm_sizes[clsid]--;
+            break;
+          default:
+            head = &itemsp->heads[clsid];
+            tail = &itemsp->tails[clsid];
+            /* move lowMK, curMK pointer in LRU */
+            if (itemsp->lowMK[clsid] == it)
+                itemsp->lowMK[clsid] = it->prev;
+            if (itemsp->curMK[clsid] == it) {
+                itemsp->curMK[clsid] = it->prev;
+                if (itemsp->curMK[clsid] == NULL)
+                    itemsp->curMK[clsid] = itemsp->lowMK[clsid];
+            }
         }
 #ifdef ENABLE_STICKY_ITEM
     }
@@ -552,6 +1016,20 @@ static void item_unlink_q(hash_item *it)
     return;
 }
 
+/* Unlink the referenced item from LRU list.
+ * It will be linked to LRU list when the refcount become 0.
+ * See do_item_release(). Since the lock-free readers release the item
+ * without the cache lock, link it again if it has been released.
+ */
+static void item_unlink_q_busy(hash_item *it)
+{
+    item_unlink_q(it);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&it->refcount, __ATOMIC_RELAXED) == 0) {
+        item_link_q(it);
+    }
+}
+
 //static bool do_item_isvalid(hash_item *it, rel_time_t current_time)
 bool do_item_isvalid(hash_item *it, rel_time_t current_time)
 {
@@ -576,20 +1054,74 @@ bool do_item_isvalid(hash_item *it, rel_time_t current_time)
     return true; /* Yes, it's a valid item */
 }
 
+/*
+ * Retired items
+ *
+ * The freed items are retired in the item's cache partition until no
+ * lock-free reader can see them. See item_read_enter().
+ */
+static void do_item_retire_free(struct item_retire *rp, const int index)
+{
+    hash_item *it;
+    while ((it = rp->heads[index]) != NULL) {
+        rp->heads[index] = it->next;
+        rp->count--;
+        do_item_mem_free(it, ITEM_ntotal(it));
+    }
+}
+
+static void do_item_retire_reclaim(struct item_retire *rp)
+{
+    for (int i = 0; i < RETIRE_LIST_COUNT; i++) {
+        if (rp->heads[i] != NULL && read_epoch_passed(rp->epochs[i])) {
+            do_item_retire_free(rp, i);
+        }
+    }
+}
+
+static void do_item_retire(hash_item *it)
+{
+    struct item_retire *rp = &ITEM_CACHE_PART(it)->retire;
+    uint64_t epoch = read_epoch_retire();
+
+    if (rp->count > 0) {
+        do_item_retire_reclaim(rp);
+    }
+    if (read_epoch_passed(epoch)) {
+        /* no reader can see it */
+        do_item_mem_free(it, ITEM_ntotal(it));
+        return;
+    }
+    int index = epoch % RETIRE_LIST_COUNT;
+    if (rp->heads[index] != NULL && rp->epochs[index] != epoch) {
+        /* the items retired in the older epoch can be freed */
+        do_item_retire_free(rp, index);
+    }
+    it->next = rp->heads[index];
+    rp->heads[index] = it;
+    rp->epochs[index] = epoch;
+    rp->count++;
+}
+
 static hash_item *do_item_reclaim(hash_item *it,
                                   const size_t ntotal, const unsigned int clsid,
                                   const unsigned int lruid)
 {
     /* increment # of reclaimed */
-    do_item_stat_reclaim(lruid);
+    do_item_stat_reclaim(lruid, it);
 
     /* it->refcount == 0 */
 #ifdef USE_SINGLE_LRU_LIST
 #else
-    if (lruid != LRU_CLSID_FOR_SMALL) {
-        it->refcount = 1;
-        slabs_adjust_mem_requested(it->slabs_clsid, ITEM_ntotal(it), ntotal);
+    if (lruid != LRU_CLSID_FOR_SMALL && ITEM_REFCOUNT_KILL(it)) {
+        /* The killed item is not freed by do_item_unlink(). */
         do_item_unlink(it, ITEM_UNLINK_INVALID);
+        if (!read_epoch_passed(read_epoch_retire())) {
+            /* lock-free readers might see it */
+            do_item_retire(it);
+            return slabs_alloc(ntotal, clsid);
+        }
+        slabs_adjust_mem_requested(it->slabs_clsid, ITEM_ntotal(it), ntotal);
         /* Initialize the item block: */
         it->slabs_clsid = 0;
         it->refcount = 0;
@@ -611,7 +1143,7 @@ static hash_item *do_item_reclaim(hash_item *it,
 static void do_item_invalidate(hash_item *it, const unsigned int lruid, bool immediate)
 {
     /* increment # of reclaimed */
-    do_item_stat_reclaim(lruid);
+    do_item_stat_reclaim(lruid, it);
 
     /* it->refcount == 0 */
     if (immediate && IS_COLL_ITEM(it)) {
@@ -636,8 +1168,8 @@ static void do_item_evict(hash_item *it, const unsigned int lruid,
 static void do_item_repair(hash_item *it, const unsigned int lruid)
 {
     /* increment # of repaired */
-    itemsp->itemstats[lruid].tailrepairs++;
-    it->refcount = 0;
+    ITEM_CACHE_PART(it)->items.itemstats[lruid].tailrepairs++;
+    __atomic_store_n(&it->refcount, 0, __ATOMIC_RELAXED);
     it->refchunk = 0;
 
     /* unlink the item */
@@ -647,9 +1179,112 @@ static void do_item_repair(hash_item *it, const unsigned int lruid)
     do_item_unlink(it, ITEM_UNLINK_EVICT);
 }
 
+/* Drop the invalid item found while moving the LRU tail items. */
+static void do_item_lru_drop(hash_item *it, const unsigned int lruid)
+{
+    if (it->refcount == 0) {
+        do_item_invalidate(it, lruid, false);
+    } else {
+        /* It will be unlinked when it's released. */
+        item_unlink_q_busy(it);
+    }
+}
+
+/* Move the valid item to the head of the given segment. */
+static void do_item_lru_move(hash_item *it, const uint8_t seg, rel_time_t current_time)
+{
+    item_unlink_q(it);
+    if (seg == ITEM_LRU_WARM) {
+        /* the active bit is set again if it's read once more */
+        ITEM_LRU_FLAG_UPDATE(it, ITEM_LRU_ACTIVE, 0);
+    }
+    it->time = current_time;
+    item_link_q_seg(it, seg);
+}
+
+/* Move the tail item of HOT or WARM segment.
+ * The active item goes to WARM unless demoted, and the others to COLD.
+ */
+static void do_item_lru_pull_tail(struct items *itemsp, const unsigned int lruid,
+                                  const uint8_t seg, const bool demote,
+                                  rel_time_t current_time)
+{
+    hash_item *it = (seg == ITEM_LRU_HOT ? itemsp->hot_tails[lruid]
+                                         : itemsp->warm_tails[lruid]);
+    assert(it != NULL);
+    if (!do_item_isvalid(it, current_time)) {
+        do_item_lru_drop(it, lruid);
+    } else if (!demote && ITEM_LRU_IS_ACTIVE(it)) {
+        do_item_lru_move(it, ITEM_LRU_WARM, current_time);
+    } else {
+        do_item_lru_move(it, ITEM_LRU_COLD, current_time);
+    }
+}
+
+/* Fill the empty COLD segment from the HOT and WARM tails
+ * when the LRU maintainer has not caught up with the allocations.
+ */
+static void do_item_lru_feed_cold(struct items *itemsp, const unsigned int lruid,
+                                  rel_time_t current_time)
+{
+    int tries = LRU_FEED_TRIES;
+
+    while (itemsp->tails[lruid] == NULL) {
+        if (itemsp->hot_tails[lruid] != NULL && tries > 0) {
+            do_item_lru_pull_tail(itemsp, lruid, ITEM_LRU_HOT, false, current_time);
+            tries--;
+        } else if (itemsp->warm_tails[lruid] != NULL) {
+            do_item_lru_pull_tail(itemsp, lruid, ITEM_LRU_WARM, true, current_time);
+        } else if (itemsp->hot_tails[lruid] != NULL) {
+            do_item_lru_pull_tail(itemsp, lruid, ITEM_LRU_HOT, true, current_time);
+        } else {
+            break; /* no items */
+        }
+    }
+}
+
+/* Keep the HOT and WARM segments within their shares,
+ * and rescue the active items from the COLD tail to WARM.
+ * The invalid items of HOT and WARM tails are reclaimed on the way.
+ * The number of moved items is returned.
+ */
+static uint32_t do_item_lru_balance(struct items *itemsp, const unsigned int lruid,
+                                    rel_time_t current_time, uint32_t budget)
+{
+    hash_item *it;
+    uint32_t moves = 0;
+    unsigned int limit;
+
+    limit = itemsp->sizes[lruid] * LRU_HOT_PERCENT / 100;
+    while (moves < budget && itemsp->hot_sizes[lruid] > limit) {
+        do_item_lru_pull_tail(itemsp, lruid, ITEM_LRU_HOT, false, current_time);
+        moves++;
+    }
+    limit = itemsp->sizes[lruid] * LRU_WARM_PERCENT / 100;
+    while (moves < budget && itemsp->warm_sizes[lruid] > limit) {
+        it = itemsp->warm_tails[lruid];
+        if (ITEM_LRU_IS_ACTIVE(it) && do_item_isvalid(it, current_time)) {
+            /* give it one more round in WARM */
+            do_item_lru_move(it, ITEM_LRU_WARM, current_time);
+        } else {
+            do_item_lru_pull_tail(itemsp, lruid, ITEM_LRU_WARM, true, current_time);
+        }
+        moves++;
+    }
+    while (moves < budget && (it = itemsp->tails[lruid]) != NULL) {
+        if (!ITEM_LRU_IS_ACTIVE(it) || !do_item_isvalid(it, current_time)) {
+            break; /* left to be evicted or reclaimed */
+        }
+        do_item_lru_move(it, ITEM_LRU_WARM, current_time);
+        moves++;
+    }
+    return moves;
+}
+
 static uint32_t do_item_regain(const uint32_t count, rel_time_t current_time,
                                const void *cookie)
 {
+    struct items *itemsp = &CURR_CACHE_PART()->items;
     hash_item *previt;
     hash_item *search;
     uint32_t tries = count;
@@ -661,6 +1296,7 @@ static uint32_t do_item_regain(const uint32_t count, rel_time_t current_time,
     unsigned int clsid = LRU_CLSID_FOR_SMALL;
 #endif
 
+    do_item_lru_feed_cold(itemsp, clsid, current_time);
     search = itemsp->tails[clsid];
     while (search != NULL) {
         assert(search->nkey > 0);
@@ -673,11 +1309,8 @@ static uint32_t do_item_regain(const uint32_t count, rel_time_t current_time,
             }
             nregains += 1;
         } else { /* search->refcount > 0 */
-            /* We just unlink the item from LRU list.
-             * It will be linked to LRU list when the refcount become 0.
-             * See do_item_release().
-             */
-            item_unlink_q(search);
+            /* We just unlink the item from LRU list. */
+            item_unlink_q_busy(search);
         }
         search = previt;
         if ((--tries) == 0) break;
@@ -685,11 +1318,228 @@ static uint32_t do_item_regain(const uint32_t count, rel_time_t current_time,
     return nregains;
 }
 
+/* Reclaim the expired items from the LRU list of the given cache partition.
+ * The lowMK and curMK positions are used to find the expired items.
+ */
+static hash_item *do_item_reclaim_expired(struct items *itemsp,
+                                          const size_t ntotal, const unsigned int clsid,
+                                          const unsigned int lruid, rel_time_t current_time,
+                                          int *tries)
+{
+    hash_item *it = NULL;
+    hash_item *search;
+    hash_item *previt = NULL;
+    int step;
+
+    if (itemsp->curMK[lruid] == NULL) {
+        return NULL;
+    }
+    assert(itemsp->lowMK[lruid] != NULL);
+    /* step 1) reclaim items from lowMK position */
+    step = (*tries < 10 ? *tries : 10);
+    *tries -= step;
+    search = itemsp->lowMK[lruid];
+    while (step > 0 && search != NULL && search != itemsp->curMK[lruid]) {
+        if (search->refcount == 0 && !do_item_isvalid(search, current_time)) {
+            previt = search->prev;
+            it = do_item_reclaim(search, ntotal, clsid, lruid);
+            if (it != NULL) break; /* allocated */
+            search = previt;
+        } else {
+            if (search->exptime == 0 && search == itemsp->lowMK[lruid]) {
+                itemsp->lowMK[lruid] = search->prev; /* move lowMK position upward */
+            }
+            search = search->prev;
+        }
+        step--;
+    }
+    if (it != NULL) {
+        /* try one more invalidation */
+        if (previt != NULL &&
+            previt->refcount == 0 && !do_item_isvalid(previt, current_time)) {
+            do_item_invalidate(previt, lruid, false);
+        }
+        *tries += step;
+        return it;
+    }
+    /* step 2) reclaim items from curMK position */
+    *tries += step;
+    while (*tries > 0 && itemsp->curMK[lruid] != NULL) {
+        search = itemsp->curMK[lruid];
+        itemsp->curMK[lruid] = search->prev;
+        *tries -= 1;
+        if (search->refcount == 0 && !do_item_isvalid(search, current_time)) {
+            it = do_item_reclaim(search, ntotal, clsid, lruid);
+            if (it != NULL) break; /* allocated */
+        }
+    }
+    if (itemsp->curMK[lruid] == NULL) {
+        itemsp->curMK[lruid] = itemsp->lowMK[lruid];
+    }
+    if (it != NULL) {
+        /* try one more invalidation */
+        search = itemsp->curMK[lruid];
+        if (search != NULL &&
+            search->refcount == 0 && !do_item_isvalid(search, current_time)) {
+            do_item_invalidate(search, lruid, false);
+        }
+    }
+    return it;
+}
+
+/* Reclaim the expired items of the other cache partitions.
+ * Only the partitions having the items with exptime are visited,
+ * and the busy partitions are skipped.
+ */
+static hash_item *do_item_reclaim_others(const size_t ntotal, const unsigned int clsid,
+                                         const unsigned int lruid, rel_time_t current_time,
+                                         int *tries)
+{
+    static __thread int reclaim_part = 0;
+    hash_item *it = NULL;
+    struct cache_part *cp;
+    bool all_held = (cache_part_held == CACHE_PART_ALL);
+
+    for (int i = 0; i < engine->cache_part_count && it == NULL && *tries > 0; i++) {
+        cp = &engine->cache_parts[(reclaim_part++) & engine->cache_part_mask];
+        if (cp == CURR_CACHE_PART() || cp->items.curMK[lruid] == NULL) {
+            continue; /* already visited or no items with exptime */
+        }
+        if (!all_held && pthread_mutex_trylock(&cp->lock) != 0) {
+            continue; /* busy partition */
+        }
+        it = do_item_reclaim_expired(&cp->items, ntotal, clsid, lruid,
+                                     current_time, tries);
+        if (!all_held) {
+            pthread_mutex_unlock(&cp->lock);
+        }
+    }
+    return it;
+}
+
+/* Evict the items from the LRU tail of the given cache partition
+ * until the memory of the given size is allocated.
+ */
+static hash_item *do_item_evict_alloc(struct items *itemsp,
+                                      const size_t ntotal, const unsigned int clsid,
+                                      const unsigned int lruid, rel_time_t current_time,
+                                      const void *cookie, int *tries)
+{
+    hash_item *it = NULL;
+    hash_item *previt;
+    hash_item *search = itemsp->tails[lruid];
+
+    while (search != NULL) {
+        assert(search->nkey > 0);
+        previt = search->prev;
+        if (ITEM_LRU_IS_ACTIVE(search) && do_item_isvalid(search, current_time)) {
+            /* the active item is rescued to WARM */
+            do_item_lru_move(search, ITEM_LRU_WARM, current_time);
+        } else if (search->refcount == 0) {
+            if (do_item_isvalid(search, current_time)) {
+                do_item_evict(search, lruid, current_time, cookie);
+                it = slabs_alloc(ntotal, clsid);
+            } else {
+                it = do_item_reclaim(search, ntotal, clsid, lruid);
+            }
+            if (it != NULL) break; /* allocated */
+        } else { /* search->refcount > 0 */
+            /* just unlink the item from LRU list. */
+            item_unlink_q_busy(search);
+        }
+        search = previt;
+        if ((--(*tries)) == 0) break;
+    }
+    return it;
+}
+
+/* Unlock the cache partition locked by do_item_oldest_part()
+ * or do_item_reclaim_others() if it's not held by the current thread.
+ */
+static inline void do_item_unlock_part(struct cache_part *cp)
+{
+    if (cache_part_held != CACHE_PART_ALL &&
+        cp != &engine->cache_parts[cache_part_held]) {
+        pthread_mutex_unlock(&cp->lock);
+    }
+}
+
+/* Check if the LRU tail item of a is older than that of b. */
+static inline bool do_item_tail_older(hash_item *a, hash_item *b)
+{
+    if (a->time != b->time) {
+        return a->time < b->time;
+    }
+    return item_get_cas(a) < item_get_cas(b);
+}
+
+/* Find the cache partition whose COLD tail item is the oldest one
+ * so that the eviction order follows the global LRU order.
+ * The empty COLD segments are filled from HOT and WARM segments.
+ * The cache locks of other partitions are not waited for
+ * in order to avoid deadlock. The busy partitions are skipped.
+ * The found partition is returned being locked.
+ */
+static struct cache_part *do_item_oldest_part(const unsigned int lruid,
+                                              rel_time_t current_time)
+{
+    struct cache_part *best = NULL;
+    struct cache_part *cp;
+    bool all_held = (cache_part_held == CACHE_PART_ALL);
+
+    for (int i = 0; i < engine->cache_part_count; i++) {
+        cp = &engine->cache_parts[i];
+        if (!all_held && i != cache_part_held) {
+            if (pthread_mutex_trylock(&cp->lock) != 0) {
+                continue; /* busy partition */
+            }
+        }
+        do_item_lru_feed_cold(&cp->items, lruid, current_time);
+        if (cp->items.tails[lruid] != NULL &&
+            (best == NULL || do_item_tail_older(cp->items.tails[lruid],
+                                                best->items.tails[lruid]))) {
+            if (best != NULL) do_item_unlock_part(best);
+            best = cp;
+        } else {
+            do_item_unlock_part(cp);
+        }
+    }
+    return best;
+}
+
+/* Evict the oldest items across the cache partitions
+ * until the memory of the given size is allocated.
+ */
+static hash_item *do_item_evict_alloc_oldest(const size_t ntotal, const unsigned int clsid,
+                                             const unsigned int lruid, rel_time_t current_time,
+                                             const void *cookie, int *tries)
+{
+    hash_item *it = NULL;
+    struct cache_part *cp;
+    int step;
+
+    while (it == NULL && *tries > 0) {
+        if ((cp = do_item_oldest_part(lruid, current_time)) == NULL) {
+            break; /* nothing to evict */
+        }
+        step = 1;
+        it = do_item_evict_alloc(&cp->items, ntotal, clsid, lruid,
+                                 current_time, cookie, &step);
+        do_item_unlock_part(cp);
+        *tries -= 1;
+    }
+    return it;
+}
+
 //static void *do_item_mem_alloc(const size_t ntotal, const unsigned int clsid,
 //                               const void *cookie)
 void *do_item_mem_alloc(const size_t ntotal, const unsigned int clsid,
                         const void *cookie)
 {
+    /* The items are reclaimed or evicted from the LRU lists
+     * of the cache partition locked by the current thread.
+     */
+    struct items *itemsp = &CURR_CACHE_PART()->items;
     hash_item *it = NULL;
 
     /* do a quick check if we have any expired items in the tail.. */
@@ -758,58 +1608,20 @@ void *do_item_mem_alloc(const size_t ntotal, const unsigned int clsid,
     }
 #endif
 
-    if (itemsp->curMK[lruid] != NULL) {
-        assert(itemsp->lowMK[lruid] != NULL);
-        /* step 1) reclaim items from lowMK position */
-        tries = 10;
-        search = itemsp->lowMK[lruid];
-        while (search != NULL && search != itemsp->curMK[lruid]) {
-            if (search->refcount == 0 && !do_item_isvalid(search, current_time)) {
-                previt = search->prev;
-                it = do_item_reclaim(search, ntotal, clsid_based_on_ntotal, lruid);
-                if (it != NULL) break; /* allocated */
-                search = previt;
-            } else {
-                if (search->exptime == 0 && search == itemsp->lowMK[lruid]) {
-                    itemsp->lowMK[lruid] = search->prev; /* move lowMK position upward */
-                }
-                search = search->prev;
-            }
-            if ((--tries) == 0) break;
-        }
-        if (it != NULL) {
-            /* try one more invalidation */
-            if (previt != NULL &&
-                previt->refcount == 0 && !do_item_isvalid(previt, current_time)) {
-                do_item_invalidate(previt, lruid, false);
-            }
-            it->slabs_clsid = 0;
-            return (void *)it;
-        }
-        /* step 2) reclaim items from curMK position */
-        tries += 20;
-        while (itemsp->curMK[lruid] != NULL) {
-            search = itemsp->curMK[lruid];
-            itemsp->curMK[lruid] = search->prev;
-            if (search->refcount == 0 && !do_item_isvalid(search, current_time)) {
-                it = do_item_reclaim(search, ntotal, clsid_based_on_ntotal, lruid);
-                if (it != NULL) break; /* allocated */
-            }
-            if ((--tries) == 0) break;
-        }
-        if (itemsp->curMK[lruid] == NULL) {
-            itemsp->curMK[lruid] = itemsp->lowMK[lruid];
-        }
-        if (it != NULL) {
-            /* try one more invalidation */
-            search = itemsp->curMK[lruid];
-            if (search != NULL &&
-                search->refcount == 0 && !do_item_isvalid(search, current_time)) {
-                do_item_invalidate(search, lruid, false);
-            }
-            it->slabs_clsid = 0;
-            return (void *)it;
-        }
+    /* reclaim the expired items of the current partition first,
+     * and then those of the other partitions.
+     */
+    tries = 30;
+    it = do_item_reclaim_expired(itemsp, ntotal, clsid_based_on_ntotal, lruid,
+                                 current_time, &tries);
+    if (it == NULL) {
+        tries = 30;
+        it = do_item_reclaim_others(ntotal, clsid_based_on_ntotal, lruid,
+                                    current_time, &tries);
+    }
+    if (it != NULL) {
+        it->slabs_clsid = 0;
+        return (void *)it;
     }
 
     it = slabs_alloc(ntotal, clsid_based_on_ntotal);
@@ -833,25 +1645,8 @@ void *do_item_mem_alloc(const size_t ntotal, const unsigned int clsid,
          * tries
          */
         tries  = 200;
-        search = itemsp->tails[lruid];
-        while (search != NULL) {
-            assert(search->nkey > 0);
-            previt = search->prev;
-            if (search->refcount == 0) {
-                if (do_item_isvalid(search, current_time)) {
-                    do_item_evict(search, lruid, current_time, cookie);
-                    it = slabs_alloc(ntotal, clsid_based_on_ntotal);
-                } else {
-                    it = do_item_reclaim(search, ntotal, clsid_based_on_ntotal, lruid);
-                }
-                if (it != NULL) break; /* allocated */
-            } else { /* search->refcount > 0 */
-                /* just unlink the item from LRU list. */
-                item_unlink_q(search);
-            }
-            search = previt;
-            if ((--tries) == 0) break;
-        }
+        it = do_item_evict_alloc_oldest(ntotal, clsid_based_on_ntotal, lruid,
+                                        current_time, cookie, &tries);
         if (it != NULL) {
             if (config->verbose > 1) {
                 logger->log(EXTENSION_LOG_DEBUG, NULL,
@@ -948,7 +1743,6 @@ hash_item *do_item_alloc(const void *key, const uint32_t nkey,
         return NULL;
     }
     it->slabs_clsid = id;
-    assert(it != itemsp->heads[it->slabs_clsid]);
 
     it->next = it->prev = it; /* special meaning: unlinked from LRU */
     it->h_next = 0;
@@ -961,6 +1755,10 @@ hash_item *do_item_alloc(const void *key, const uint32_t nkey,
     it->flags = flags;
     if (key != NULL) {
         memcpy((void*)item_get_key(it), key, nkey);
+        /* The key hash decides the cache partition of the item */
+        it->khash = GEN_ITEM_KEY_HASH(key, nkey);
+    } else {
+        it->khash = 0;
     }
     it->exptime = exptime;
     it->pfxptr = NULL;
@@ -971,9 +1769,9 @@ hash_item *do_item_alloc(const void *key, const uint32_t nkey,
 void do_item_free(hash_item *it)
 {
     assert((it->iflag & ITEM_LINKED) == 0);
-    assert(it != itemsp->heads[it->slabs_clsid]);
-    assert(it != itemsp->tails[it->slabs_clsid]);
-    assert(it->refcount == 0);
+    assert(it != ITEM_CACHE_PART(it)->items.heads[it->slabs_clsid]);
+    assert(it != ITEM_CACHE_PART(it)->items.tails[it->slabs_clsid]);
+    assert(it->refcount == ITEM_REFCOUNT_DEAD);
 
     if (IS_COLL_ITEM(it)) {
         coll_meta_info *info = (coll_meta_info *)item_get_meta(it);
@@ -985,7 +1783,7 @@ void do_item_free(hash_item *it)
 
     /* so slab size changer can tell later if item is already free or not */
     DEBUG_REFCNT(it, 'F');
-    do_item_mem_free(it, ITEM_ntotal(it));
+    do_item_retire(it);
 }
 
 //static ENGINE_ERROR_CODE do_item_link(hash_item *it)
@@ -997,7 +1795,7 @@ ENGINE_ERROR_CODE do_item_link(hash_item *it)
     MEMCACHED_ITEM_LINK(key, it->nkey, it->nbytes);
 
     /* Allocate a new CAS ID on link. */
-    item_set_cas(it, get_cas_id());
+    item_set_cas(it, get_cas_id(0));
 
     /* link the item to prefix info */
     size_t stotal = ITEM_stotal(it);
@@ -1064,7 +1862,7 @@ void do_item_unlink(hash_item *it, enum item_unlink_cause cause)
         }
 
         /* free the item if no one reference it */
-        if (it->refcount == 0) {
+        if (ITEM_REFCOUNT_KILL(it)) {
             do_item_free(it);
         }
     }
@@ -1084,7 +1882,7 @@ void do_item_replace(hash_item *old_it, hash_item *new_it)
     item_unlink_q(old_it);
 
     /* Allocate a new CAS ID on link. */
-    item_set_cas(new_it, get_cas_id());
+    item_set_cas(new_it, get_cas_id(item_get_cas(old_it)));
 
     /* link the item to the hash table */
     new_it->iflag |= ITEM_LINKED;
@@ -1121,7 +1919,7 @@ void do_item_replace(hash_item *old_it, hash_item *new_it)
     }
 
     /* free the item if no one reference it */
-    if (old_it->refcount == 0) {
+    if (ITEM_REFCOUNT_KILL(old_it)) {
         do_item_free(old_it);
     }
 
@@ -1136,21 +1934,20 @@ void do_item_update(hash_item *it, bool force)
     MEMCACHED_ITEM_UPDATE(item_get_key(it), it->nkey, it->nbytes);
 
     if ((it->iflag & ITEM_LINKED) != 0) {
-        rel_time_t current_time = svcore->get_current_time();
         if (force) {
             /* The exceptional case when exptime is changed.
              * See do_item_setattr() for specific explanation.
              */
             item_unlink_q(it);
-            it->time = current_time;
+            it->time = svcore->get_current_time();
             item_link_q(it);
-        } else if (it->time < (current_time - ITEM_UPDATE_INTERVAL)) {
+        } else {
             /* The normal case when the given item is read.
+             * It's only marked, and moved by the LRU maintainer.
              */
-            item_unlink_q(it);
-            it->time = current_time;
-            item_link_q(it);
-            CLOG_ITEM_UPDATE(it);
+            if (item_lru_access(it)) {
+                CLOG_ITEM_UPDATE(it);
+            }
         }
     }
 }
@@ -1204,7 +2001,9 @@ void do_item_release(hash_item *it)
     }
     if (it->refcount == 0) {
         if ((it->iflag & ITEM_LINKED) == 0) {
-            do_item_free(it);
+            if (ITEM_REFCOUNT_KILL(it)) {
+                do_item_free(it);
+            }
         }
         else if (it->prev == it && it->next == it) {
             /* re-link the item into the LRU list */
@@ -1219,6 +2018,93 @@ void do_item_release(hash_item *it)
     }
 }
 
+/* Check if the item is linked to both hash table and LRU list.
+ * Such an item can be released without the cache lock.
+ */
+static inline bool do_item_isstable(hash_item *it)
+{
+    return (__atomic_load_n(&it->iflag, __ATOMIC_RELAXED) & ITEM_LINKED) != 0 &&
+           !(it->prev == it && it->next == it);
+}
+
+/* Get the simple key-value item without the cache lock.
+ * NULL is returned if the item cannot be got in the lock-free way.
+ * Then, the caller must get it again with the cache lock.
+ */
+hash_item *item_get_lockfree(const char *key, const uint32_t nkey, const uint32_t hash)
+{
+    hash_item *it;
+    rel_time_t current_time = svcore->get_current_time();
+    bool valid = false;
+
+    if (!item_read_enter()) {
+        return NULL;
+    }
+    it = assoc_find(key, nkey, hash);
+    if (it != NULL) {
+        if (!IS_COLL_ITEM(it) && ITEM_REFCOUNT_TRYINCR(it)) {
+            /* The referenced item is not freed, but it can be unlinked.
+             * The prefix of the item is checked in the read section.
+             */
+            valid = (__atomic_load_n(&it->iflag, __ATOMIC_RELAXED) & ITEM_LINKED) != 0 &&
+                    do_item_isvalid(it, current_time);
+        } else {
+            it = NULL;
+        }
+    }
+    item_read_exit();
+
+    if (it != NULL) {
+        if (!valid) {
+            /* let the caller handle the invalid item */
+            LOCK_CACHE(hash);
+            do_item_release(it);
+            UNLOCK_CACHE();
+            return NULL;
+        }
+        DEBUG_REFCNT(it, '+');
+        (void)item_lru_access(it);
+    }
+    return it;
+}
+
+/* Release the item without the cache lock.
+ * false is returned if the item must be released with the cache lock.
+ */
+bool item_release_lockfree(hash_item *it)
+{
+    uint16_t refcount;
+    bool released = false;
+
+    if (!item_read_enter()) {
+        return false;
+    }
+    /* The read section keeps the item from being freed
+     * after the last reference is released.
+     */
+    refcount = __atomic_load_n(&it->refcount, __ATOMIC_RELAXED);
+    while (refcount > 0 && refcount < ITEM_REFCOUNT_MOVE) {
+        if (refcount == 1 && (it->refchunk > 0 || !do_item_isstable(it))) {
+            break; /* the last release needs the cache lock */
+        }
+        if (__atomic_compare_exchange_n(&it->refcount, &refcount, refcount-1, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            released = true;
+            break;
+        }
+    }
+    if (released && refcount == 1 && !do_item_isstable(it)) {
+        /* The item has been unlinked during the release.
+         * Take back the reference unless the unlinker has killed it.
+         */
+        if (__sync_bool_compare_and_swap(&it->refcount, 0, 1)) {
+            released = false;
+        }
+    }
+    item_read_exit();
+    return released;
+}
+
 /*
  * Item Management Daemon
  */
@@ -1256,13 +2142,14 @@ static void *collection_delete_thread(void *arg)
     uint32_t        evict_count;
     uint32_t        bg_evict_count = 0;
     bool            bg_evict_start = false;
+    uint32_t        evict_part = 0;
 
     coll_del_thread_running = true;
 
     while (engine->initialized) {
         it = pop_coll_del_queue();
         if (it != NULL) {
-            LOCK_CACHE();
+            LOCK_CACHE(it->khash);
             delete_count = do_coll_elem_delete_with_count(it, BG_ELEM_DELETE_COUNT);
             while (delete_count >= BG_ELEM_DELETE_COUNT) {
                 UNLOCK_CACHE();
@@ -1270,7 +2157,7 @@ static void *collection_delete_thread(void *arg)
                     sleep_time.tv_nsec = 10000; /* 10 us */
                     nanosleep(&sleep_time, NULL);
                 }
-                LOCK_CACHE();
+                LOCK_CACHE(it->khash);
                 delete_count = do_coll_elem_delete_with_count(it, BG_ELEM_DELETE_COUNT);
             }
             /* it has become an empty collection. */
@@ -1283,7 +2170,8 @@ static void *collection_delete_thread(void *arg)
         if (config->evict_to_free) {
             current_ssl = slabs_space_shortage_level();
             if (current_ssl >= 10) {
-                LOCK_CACHE();
+                /* evict the items of each cache partition in turn */
+                LOCK_CACHE(evict_part++);
                 if (config->evict_to_free) {
                     rel_time_t current_time = svcore->get_current_time();
                     evict_count = do_item_regain(current_ssl, current_time, NULL);
@@ -1291,6 +2179,16 @@ static void *collection_delete_thread(void *arg)
                 UNLOCK_CACHE();
             }
         }
+
+        /* free the retired items */
+        for (int i = 0; i < engine->cache_part_count; i++) {
+            if (engine->cache_parts[i].retire.count > 0) {
+                LOCK_CACHE(i);
+                do_item_retire_reclaim(&engine->cache_parts[i].retire);
+                UNLOCK_CACHE();
+            }
+        }
+
         if (evict_count > 0) {
             if (bg_evict_start == false) {
                 /*****
@@ -1339,6 +2237,189 @@ void coll_del_thread_wakeup(void)
     pthread_mutex_unlock(&coll_del_lock);
 }
 
+/*
+ * LRU Maintainer
+ */
+static void lru_maint_thread_sleep(uint32_t usec)
+{
+    struct timeval  tv;
+    struct timespec to;
+    pthread_mutex_lock(&lru_maint_lock);
+    gettimeofday(&tv, NULL);
+    tv.tv_usec += usec;
+    while (tv.tv_usec >= 1000000) {
+        tv.tv_sec += 1;
+        tv.tv_usec -= 1000000;
+    }
+    to.tv_sec = tv.tv_sec;
+    to.tv_nsec = tv.tv_usec * 1000;
+
+    lru_maint_sleep = true;
+    pthread_cond_timedwait(&lru_maint_cond, &lru_maint_lock, &to);
+    lru_maint_sleep = false;
+    pthread_mutex_unlock(&lru_maint_lock);
+}
+
+/* Move the items of a drained bump batch to WARM.
+ * The items are grouped by cache partition so that
+ * each partition is locked once for the batch.
+ */
+static void lru_bump_apply(hash_item **items, const uint32_t count)
+{
+    hash_item *it;
+    rel_time_t current_time;
+    uint32_t i, j, pid;
+
+    /* insertion sort by cache partition */
+    for (i = 1; i < count; i++) {
+        it = items[i];
+        pid = it->khash & engine->cache_part_mask;
+        for (j = i; j > 0 && (items[j-1]->khash & engine->cache_part_mask) > pid; j--) {
+            items[j] = items[j-1];
+        }
+        items[j] = it;
+    }
+    for (i = 0; i < count; ) {
+        pid = items[i]->khash & engine->cache_part_mask;
+        LOCK_CACHE(pid);
+        current_time = svcore->get_current_time();
+        for (; i < count && (items[i]->khash & engine->cache_part_mask) == pid; i++) {
+            it = items[i];
+            if ((it->iflag & ITEM_LINKED) != 0 && !(it->prev == it && it->next == it) &&
+                ITEM_LRU_SEGMENT_OF(it) == ITEM_LRU_COLD && ITEM_LRU_IS_ACTIVE(it) &&
+                do_item_isvalid(it, current_time)) {
+                do_item_lru_move(it, ITEM_LRU_WARM, current_time);
+                lru_bump_stats.applied++;
+            }
+            do_item_release(it); /* unpin */
+        }
+        UNLOCK_CACHE();
+    }
+}
+
+/* Drain the bump buffers of all threads.
+ * The number of drained items is returned.
+ */
+static uint32_t lru_bump_drain(void)
+{
+    hash_item *items[LRU_BUMP_BUF_SIZE];
+    struct lru_bump_buf *bb;
+    uint32_t count, total = 0;
+    uint32_t nbuf = __atomic_load_n(&lru_bump_buf_count, __ATOMIC_ACQUIRE);
+
+    if (nbuf > LRU_BUMP_BUF_COUNT) {
+        nbuf = LRU_BUMP_BUF_COUNT;
+    }
+    for (uint32_t i = 0; i < nbuf; i++) {
+        bb = __atomic_load_n(&lru_bump_bufs[i], __ATOMIC_ACQUIRE);
+        if (bb == NULL || __atomic_load_n(&bb->count, __ATOMIC_RELAXED) == 0) {
+            continue;
+        }
+        pthread_mutex_lock(&bb->lock);
+        count = bb->count;
+        memcpy(items, bb->items, count * sizeof(hash_item *));
+        bb->count = 0;
+        pthread_mutex_unlock(&bb->lock);
+        if (count == 0) {
+            continue;
+        }
+        lru_bump_apply(items, count);
+        lru_bump_stats.batches++;
+        lru_bump_stats.batch_items += count;
+        if (lru_bump_stats.batch_max < count) {
+            lru_bump_stats.batch_max = count;
+        }
+        total += count;
+    }
+    return total;
+}
+
+static void *lru_maintainer_thread(void *arg)
+{
+    struct default_engine *engine = arg;
+    struct items *itemsp;
+    rel_time_t    current_time;
+    uint32_t      moves;
+    uint32_t      sleep_usec = 1000;
+
+    lru_maint_thread_running = true;
+
+    while (engine->initialized) {
+        moves = lru_bump_drain();
+        for (int i = 0; i < engine->cache_part_count && engine->initialized; i++) {
+            itemsp = &engine->cache_parts[i].items;
+            uint32_t part_moves = 0;
+            LOCK_CACHE(i);
+            current_time = svcore->get_current_time();
+            for (int lruid = 0; lruid <= POWER_LARGEST; lruid++) {
+                if (itemsp->sizes[lruid] > 0 && part_moves < LRU_MAINT_MOVES) {
+                    part_moves += do_item_lru_balance(itemsp, lruid, current_time,
+                                                      LRU_MAINT_MOVES - part_moves);
+                }
+            }
+            UNLOCK_CACHE();
+            moves += part_moves;
+            lru_bump_stats.maint_moves += part_moves;
+        }
+        /* sleep shorter while there is work to do */
+        if (moves > 0) {
+            sleep_usec = 1000; /* 1 ms */
+        } else if (sleep_usec < 100000) {
+            sleep_usec *= 2; /* up to about 100 ms */
+        }
+        lru_maint_thread_sleep(sleep_usec);
+    }
+
+    lru_maint_thread_running = false;
+    return NULL;
+}
+
+static void lru_maint_thread_wakeup(void)
+{
+    pthread_mutex_lock(&lru_maint_lock);
+    if (lru_maint_sleep == true) {
+        pthread_cond_signal(&lru_maint_cond);
+    }
+    pthread_mutex_unlock(&lru_maint_lock);
+}
+
+void item_lru_stats(ADD_STAT add_stat, const void *cookie)
+{
+    struct lru_bump_buf *bb;
+    char val[128];
+    int len;
+    uint64_t queued = 0, dropped = 0;
+    uint32_t nbuf = __atomic_load_n(&lru_bump_buf_count, __ATOMIC_ACQUIRE);
+
+    if (nbuf > LRU_BUMP_BUF_COUNT) {
+        nbuf = LRU_BUMP_BUF_COUNT;
+    }
+    for (uint32_t i = 0; i < nbuf; i++) {
+        bb = __atomic_load_n(&lru_bump_bufs[i], __ATOMIC_ACQUIRE);
+        if (bb != NULL) {
+            queued += __atomic_load_n(&bb->queued, __ATOMIC_RELAXED);
+            dropped += __atomic_load_n(&bb->dropped, __ATOMIC_RELAXED);
+        }
+    }
+    len = sprintf(val, "%u", nbuf);
+    add_stat("lru_bump_buffers", 16, val, len, cookie);
+    len = sprintf(val, "%"PRIu64, queued);
+    add_stat("lru_bumps_queued", 16, val, len, cookie);
+    len = sprintf(val, "%"PRIu64, dropped);
+    add_stat("lru_bumps_dropped", 17, val, len, cookie);
+    len = sprintf(val, "%"PRIu64, lru_bump_stats.applied);
+    add_stat("lru_bumps_applied", 17, val, len, cookie);
+    len = sprintf(val, "%"PRIu64, lru_bump_stats.batches);
+    add_stat("lru_bump_batches", 16, val, len, cookie);
+    len = sprintf(val, "%.1f", lru_bump_stats.batches == 0 ? 0.0 :
+                  (double)lru_bump_stats.batch_items / lru_bump_stats.batches);
+    add_stat("lru_bump_batch_avg", 18, val, len, cookie);
+    len = sprintf(val, "%"PRIu64, lru_bump_stats.batch_max);
+    add_stat("lru_bump_batch_max", 18, val, len, cookie);
+    len = sprintf(val, "%"PRIu64, lru_bump_stats.maint_moves);
+    add_stat("lru_maintainer_moves", 20, val, len, cookie);
+}
+
 /*
  * Item access functions
  */
@@ -1409,12 +2490,21 @@ int item_base_init(void *engine_ptr)
 {
     engine = (struct default_engine *)engine_ptr;
     config = &engine->config;
-    itemsp = &engine->items;
-    statsp = &engine->stats;
     svstat = engine->server.stat;
     svcore = engine->server.core;
     logger = engine->server.log->get_logger();
 
+    /* cache partitions */
+    for (int i = 0; i < engine->cache_part_count; i++) {
+        struct cache_part *cp = &engine->cache_parts[i];
+        pthread_mutex_init(&cp->lock, NULL);
+        pthread_mutex_init(&cp->stats.lock, NULL);
+    }
+    /* element locks */
+    for (int i = 0; i < ELEM_LOCK_COUNT; i++) {
+        pthread_mutex_init(&elem_locks[i], NULL);
+    }
+
     /* collection delete queue */
     pthread_mutex_init(&coll_del_lock, NULL);
     pthread_cond_init(&coll_del_cond, NULL);
@@ -1428,6 +2518,17 @@ int item_base_init(void *engine_ptr)
         return -1;
     }
 
+    /* LRU maintainer */
+    pthread_mutex_init(&lru_maint_lock, NULL);
+    pthread_cond_init(&lru_maint_cond, NULL);
+
+    ret = pthread_create(&lru_maint_tid, NULL, lru_maintainer_thread, engine);
+    if (ret != 0) {
+        logger->log(EXTENSION_LOG_WARNING, NULL,
+                    "Can't create thread: %s\n", strerror(ret));
+        return -1;
+    }
+
     logger->log(EXTENSION_LOG_INFO, NULL, "ITEM base module initialized.\n");
     return 0;
 }
@@ -1438,5 +2539,24 @@ void item_base_final(void *engine_ptr)
         coll_del_thread_wakeup();
         pthread_join(coll_del_tid, NULL);
     }
+    if (lru_maint_thread_running) {
+        lru_maint_thread_wakeup();
+        pthread_join(lru_maint_tid, NULL);
+    }
+    for (int i = 0; i < LRU_BUMP_BUF_COUNT; i++) {
+        if (lru_bump_bufs[i] != NULL) {
+            pthread_mutex_destroy(&lru_bump_bufs[i]->lock);
+            free(lru_bump_bufs[i]);
+            lru_bump_bufs[i] = NULL;
+        }
+    }
+    for (int i = 0; i < ELEM_LOCK_COUNT; i++) {
+        pthread_mutex_destroy(&elem_locks[i]);
+    }
+    for (int i = 0; i < engine->cache_part_count; i++) {
+        struct cache_part *cp = &engine->cache_parts[i];
+        pthread_mutex_destroy(&cp->lock);
+        pthread_mutex_destroy(&cp->stats.lock);
+    }
     logger->log(EXTENSION_LOG_INFO, NULL, "ITEM base module destroyed.\n");
 }
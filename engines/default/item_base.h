@@ -46,6 +46,11 @@
 #define MAXIMUM_SCRUB_COUNT 320
 #define DEFAULT_SCRUB_COUNT 96
 
+/* cache partition count : must be a power of 2 */
+#define MINIMUM_CACHE_PARTS 1
+#define MAXIMUM_CACHE_PARTS 1024
+#define DEFAULT_CACHE_PARTS 32
+
 /* update type */
 enum upd_type {
     /* key value command */
@@ -110,6 +115,16 @@ enum elem_delete_cause {
 #define ITEM_INTERNAL    64  /* internal cache item */
 #define ITEM_WITH_CAS    128 /* having CAS value */
 
+/* Item LRU flag (1 byte) : LRU segment and access bits */
+/* 1) LRU segment: the item is evicted from the COLD segment */
+#define ITEM_LRU_COLD    0
+#define ITEM_LRU_HOT     1
+#define ITEM_LRU_WARM    2
+#define ITEM_LRU_SEGMENT 3
+/* 2) access bits: set by readers without the cache lock */
+#define ITEM_LRU_FETCHED 4   /* read once */
+#define ITEM_LRU_ACTIVE  8   /* read again after fetched */
+
 /* Macros for checking item type */
 #define GET_ITEM_TYPE(it) ((it)->iflag & ITEM_IFLAG_COLL)
 #define IS_LIST_ITEM(it)  (((it)->iflag & ITEM_IFLAG_COLL) == ITEM_IFLAG_LIST)
@@ -156,6 +171,7 @@ typedef struct _hash_item {
     rel_time_t time;    /* least recent access */
     rel_time_t exptime; /* When the item will expire (relative to process startup) */
     uint8_t  iflag;     /* Internal flags: item type and flag */
+    uint8_t  lruflag;   /* LRU flags: LRU segment and access bits */
     uint16_t nkey;      /* The total length of the key (in bytes) */
     uint32_t nbytes;    /* The total length of the data (in bytes) */
     /* Following fields are used to trade off memory space for performance */
@@ -338,25 +354,68 @@ typedef struct {
 
 /* item global */
 struct items {
+   /* LRU lists: heads/tails are the COLD segment */
    hash_item   *heads[MAX_SLAB_CLASSES];
    hash_item   *tails[MAX_SLAB_CLASSES];
+   hash_item   *hot_heads[MAX_SLAB_CLASSES];
+   hash_item   *hot_tails[MAX_SLAB_CLASSES];
+   hash_item   *warm_heads[MAX_SLAB_CLASSES];
+   hash_item   *warm_tails[MAX_SLAB_CLASSES];
    hash_item   *lowMK[MAX_SLAB_CLASSES]; /* low mark for invalidation(expire/flush) check */
    hash_item   *curMK[MAX_SLAB_CLASSES]; /* cur mark for invalidation(expire/flush) check */
    hash_item   *sticky_heads[MAX_SLAB_CLASSES];
    hash_item   *sticky_tails[MAX_SLAB_CLASSES];
    hash_item   *sticky_curMK[MAX_SLAB_CLASSES]; /* cur mark for invalidation(expire/flush) check */
-   unsigned int sizes[MAX_SLAB_CLASSES];
+   unsigned int sizes[MAX_SLAB_CLASSES];      /* all segments */
+   unsigned int hot_sizes[MAX_SLAB_CLASSES];
+   unsigned int warm_sizes[MAX_SLAB_CLASSES];
    unsigned int sticky_sizes[MAX_SLAB_CLASSES];
    itemstats_t  itemstats[MAX_SLAB_CLASSES];
 };
 
+/* The freed items that might still be seen by lock-free readers.
+ * They are kept in the list of the epoch they were retired in
+ * and are really freed once all readers have passed that epoch.
+ */
+#define RETIRE_LIST_COUNT 3
+
+struct item_retire {
+   hash_item   *heads[RETIRE_LIST_COUNT]; /* linked through it->next */
+   uint64_t     epochs[RETIRE_LIST_COUNT];
+   uint32_t     count;
+};
+
 void ITEM_REFCOUNT_INCR(hash_item *it);
 void ITEM_REFCOUNT_DECR(hash_item *it);
 
+/* The element refcount is incremented with the cache lock held,
+ * but it can be decremented without the cache lock by element release.
+ * See LOCK_ELEM() for the release protocol.
+ */
+#define ELEM_REFCOUNT_INCR(elem) ((void)__sync_add_and_fetch(&(elem)->refcount, 1))
+#define ELEM_REFCOUNT_DECR(elem) ((void)__sync_sub_and_fetch(&(elem)->refcount, 1))
+
+/* cache lock functions */
+uint32_t item_key_hash(const void *key, const uint32_t nkey);
+void     LOCK_CACHE(const uint32_t hash);
+void     LOCK_CACHE_ANY(void);
+void     LOCK_CACHE_ALL(void);
+void     UNLOCK_CACHE(void);
+
+/* element lock functions */
+void     LOCK_ELEM(const void *elem);
+void     UNLOCK_ELEM(const void *elem);
+
+/* lock-free read section functions */
+bool     item_read_enter(void);
+void     item_read_exit(void);
+void     item_read_synchronize(void);
+
 /* stats functions */
 void do_item_stat_get(ADD_STAT add_stat, const void *cookie);
 void do_item_stat_reset(void);
 #ifdef ENABLE_STICKY_ITEM
+uint64_t do_item_sticky_bytes(void);
 bool do_item_sticky_overflowed(void);
 #endif
 
@@ -385,8 +444,12 @@ void              do_item_update(hash_item *it, bool force);
 hash_item *do_item_get(const char *key, const uint32_t nkey, bool do_update);
 void       do_item_release(hash_item *it);
 
+hash_item *item_get_lockfree(const char *key, const uint32_t nkey, const uint32_t hash);
+bool       item_release_lockfree(hash_item *it);
+
 
 void coll_del_thread_wakeup(void);
+void item_lru_stats(ADD_STAT add_stat, const void *cookie);
 
 /*
  * Item access functions
@@ -36,37 +36,9 @@
 
 static struct default_engine *engine=NULL;
 static struct engine_config *config=NULL; // engine config
-static struct items         *itemsp=NULL;
 static SERVER_CORE_API      *svcore=NULL; // server core api
 static EXTENSION_LOGGER_DESCRIPTOR *logger;
 
-/*
- * Static functions
- */
-static inline void LOCK_CACHE(void)
-{
-    pthread_mutex_lock(&engine->cache_lock);
-}
-
-static inline void UNLOCK_CACHE(void)
-{
-    pthread_mutex_unlock(&engine->cache_lock);
-}
-
-static inline void TRYLOCK_CACHE(int ntries)
-{
-    int i;
-
-    for (i = 0; i < ntries; i++) {
-        if (pthread_mutex_trylock(&engine->cache_lock) == 0)
-            break;
-        sched_yield();
-    }
-    if (i == ntries) {
-        pthread_mutex_lock(&engine->cache_lock);
-    }
-}
-
 /*
  * Stores an item in the cache according to the semantics of one of the set
  * commands. In threaded mode, this is protected by the cache lock.
@@ -284,8 +256,12 @@ hash_item *item_alloc(const void *key, const uint32_t nkey,
                       const uint32_t nbytes, const void *cookie)
 {
     hash_item *it;
-    LOCK_CACHE();
     /* key can be NULL */
+    if (key != NULL) {
+        LOCK_CACHE(item_key_hash(key, nkey));
+    } else {
+        LOCK_CACHE_ANY();
+    }
     it = do_item_alloc(key, nkey, flags, exptime, nbytes, cookie);
     UNLOCK_CACHE();
     return it;
@@ -298,9 +274,15 @@ hash_item *item_alloc(const void *key, const uint32_t nkey,
 hash_item *item_get(const void *key, const uint32_t nkey)
 {
     hash_item *it;
-    LOCK_CACHE();
-    it = do_item_get(key, nkey, DO_UPDATE);
-    UNLOCK_CACHE();
+    uint32_t hash = item_key_hash(key, nkey);
+
+    /* try the lock-free read path first */
+    it = item_get_lockfree(key, nkey, hash);
+    if (it == NULL) {
+        LOCK_CACHE(hash);
+        it = do_item_get(key, nkey, DO_UPDATE);
+        UNLOCK_CACHE();
+    }
     return it;
 }
 
@@ -310,7 +292,10 @@ hash_item *item_get(const void *key, const uint32_t nkey)
  */
 void item_release(hash_item *item)
 {
-    LOCK_CACHE();
+    if (item_release_lockfree(item)) {
+        return;
+    }
+    LOCK_CACHE(item->khash);
     do_item_release(item);
     UNLOCK_CACHE();
 }
@@ -325,7 +310,7 @@ ENGINE_ERROR_CODE item_store(hash_item *item, uint64_t *cas,
     ENGINE_ERROR_CODE ret;
     PERSISTENCE_ACTION_BEGIN(cookie, UPD_STORE);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item->khash);
     switch (operation) {
       case OPERATION_SET:
            ret = do_item_store_set(item, cas, cookie);
@@ -363,7 +348,7 @@ ENGINE_ERROR_CODE item_arithmetic(const void *key, const uint32_t nkey,
     ENGINE_ERROR_CODE ret;
     PERSISTENCE_ACTION_BEGIN(cookie, UPD_STORE);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     it = do_item_get(key, nkey, DONT_UPDATE);
     if (it) {
         if (IS_COLL_ITEM(it)) {
@@ -408,7 +393,7 @@ ENGINE_ERROR_CODE item_delete(const void *key, const uint32_t nkey, uint64_t cas
     ENGINE_ERROR_CODE ret;
     PERSISTENCE_ACTION_BEGIN(cookie, UPD_DELETE);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     it = do_item_get(key, nkey, DONT_UPDATE);
     if (it) {
         if (cas == 0 || cas == item_get_cas(it)) {
@@ -490,41 +475,48 @@ static ENGINE_ERROR_CODE do_item_flush_expired(const char *prefix, const int npr
         }
     }
 
-    if (oldest_live != 0) {
+    for (int p = 0; p < engine->cache_part_count && oldest_live != 0; p++) {
+        struct items *itemsp = &engine->cache_parts[p].items;
         for (int i = 0; i <= POWER_LARGEST; i++) {
             /*
-             * The LRU is sorted in decreasing time order, and an item's
-             * timestamp is never newer than its last access time, so we
+             * Each LRU segment is sorted in decreasing time order, and an
+             * item's timestamp is reset only when it enters a segment, so we
              * only need to walk back until we hit an item older than the
              * oldest_live time.
              * The oldest_live checking will auto-expire the remaining items.
              */
-            iter = itemsp->heads[i];
-            while (iter != NULL) {
-                if (iter->time < oldest_live) {
-                    /* We've hit the first old item. Continue to the next queue. */
-                    /* reset lowMK and curMK to tail pointer */
-                    itemsp->lowMK[i] = itemsp->tails[i];
-                    itemsp->curMK[i] = itemsp->tails[i];
-                    break;
-                }
+            hash_item **seg_heads[3] = { itemsp->hot_heads, itemsp->warm_heads,
+                                         itemsp->heads };
+            for (int seg = 0; seg < 3; seg++) {
+                iter = seg_heads[seg][i];
+                while (iter != NULL) {
+                    if (iter->time < oldest_live) {
+                        /* We've hit the first old item. Continue to the next queue. */
+                        if (seg_heads[seg] == itemsp->heads) {
+                            /* reset lowMK and curMK to tail pointer */
+                            itemsp->lowMK[i] = itemsp->tails[i];
+                            itemsp->curMK[i] = itemsp->tails[i];
+                        }
+                        break;
+                    }
 #ifdef NESTED_PREFIX
-                if (nprefix < 0 || prefix_isincluded(iter->pfxptr, prefix, nprefix)) {
-                    next = iter->next;
-                    do_item_unlink(iter, ITEM_UNLINK_INVALID);
-                    iter = next;
-                } else {
-                    iter = iter->next;
-                }
+                    if (nprefix < 0 || prefix_isincluded(iter->pfxptr, prefix, nprefix)) {
+                        next = iter->next;
+                        do_item_unlink(iter, ITEM_UNLINK_INVALID);
+                        iter = next;
+                    } else {
+                        iter = iter->next;
+                    }
 #else
-                if (nprefix < 0 || prefix_issame(iter->pfxptr, prefix, nprefix)) {
-                    next = iter->next;
-                    do_item_unlink(iter, ITEM_UNLINK_INVALID);
-                    iter = next;
-                } else {
-                    iter = iter->next;
-                }
+                    if (nprefix < 0 || prefix_issame(iter->pfxptr, prefix, nprefix)) {
+                        next = iter->next;
+                        do_item_unlink(iter, ITEM_UNLINK_INVALID);
+                        iter = next;
+                    } else {
+                        iter = iter->next;
+                    }
 #endif
+                }
             }
 #ifdef ENABLE_STICKY_ITEM
             iter = itemsp->sticky_heads[i];
@@ -555,6 +547,8 @@ static ENGINE_ERROR_CODE do_item_flush_expired(const char *prefix, const int npr
             }
 #endif
         }
+    }
+    if (oldest_live != 0) {
         CLOG_ITEM_FLUSH(prefix, nprefix, when);
     }
     return ENGINE_SUCCESS;
@@ -566,7 +560,7 @@ ENGINE_ERROR_CODE item_flush_expired(const char *prefix, const int nprefix,
     ENGINE_ERROR_CODE ret;
     PERSISTENCE_ACTION_BEGIN(cookie, UPD_FLUSH);
 
-    LOCK_CACHE();
+    LOCK_CACHE_ALL();
     ret = do_item_flush_expired(prefix, nprefix, when, cookie);
     UNLOCK_CACHE();
 
@@ -590,23 +584,45 @@ char *item_cachedump(unsigned int slabs_clsid, unsigned int limit, const bool fo
     buffer = malloc((size_t)memlimit);
     if (buffer == 0) return NULL;
 
-    LOCK_CACHE();
-    if (sticky) {
-        it = (forward ? itemsp->sticky_heads[slabs_clsid]
-                      : itemsp->sticky_tails[slabs_clsid]);
-    } else {
-        it = (forward ? itemsp->heads[slabs_clsid]
-                      : itemsp->tails[slabs_clsid]);
-    }
-    while (it != NULL) {
-        if (limit != 0 && shown >= limit) break;
-        if (bufcurr + it->nkey + 100 > memlimit) break;
-        const char *key = item_get_key(it);
-        len = sprintf(buffer + bufcurr, "ITEM %.*s [acctime=%u, exptime=%d]\r\n",
-                      it->nkey, key, it->time, (int32_t)it->exptime);
-        bufcurr += len;
-        shown++;
-        it = (forward ? it->next : it->prev);
+    LOCK_CACHE_ALL();
+    /* dump the LRU list of each cache partition in turn.
+     * The non-sticky list is dumped in HOT, WARM and COLD segment order.
+     */
+    for (int p = 0; p < engine->cache_part_count; p++) {
+        struct items *itemsp = &engine->cache_parts[p].items;
+        hash_item *lists[3];
+        int nlist;
+        if (sticky) {
+            lists[0] = (forward ? itemsp->sticky_heads[slabs_clsid]
+                                : itemsp->sticky_tails[slabs_clsid]);
+            nlist = 1;
+        } else if (forward) {
+            lists[0] = itemsp->hot_heads[slabs_clsid];
+            lists[1] = itemsp->warm_heads[slabs_clsid];
+            lists[2] = itemsp->heads[slabs_clsid];
+            nlist = 3;
+        } else {
+            lists[0] = itemsp->tails[slabs_clsid];
+            lists[1] = itemsp->warm_tails[slabs_clsid];
+            lists[2] = itemsp->hot_tails[slabs_clsid];
+            nlist = 3;
+        }
+        it = NULL;
+        for (int l = 0; l < nlist; l++) {
+            it = lists[l];
+            while (it != NULL) {
+                if (limit != 0 && shown >= limit) break;
+                if (bufcurr + it->nkey + 100 > memlimit) break;
+                const char *key = item_get_key(it);
+                len = sprintf(buffer + bufcurr, "ITEM %.*s [acctime=%u, exptime=%d]\r\n",
+                              it->nkey, key, it->time, (int32_t)it->exptime);
+                bufcurr += len;
+                shown++;
+                it = (forward ? it->next : it->prev);
+            }
+            if (it != NULL) break; /* limit reached or buffer full */
+        }
+        if (it != NULL) break; /* limit reached or buffer full */
     }
     UNLOCK_CACHE();
 
@@ -623,7 +639,7 @@ void item_stats_global(ADD_STAT add_stat, const void *cookie)
     char val[128];
     int len;
 
-    LOCK_CACHE();
+    LOCK_CACHE_ALL();
     len = sprintf(val, "%"PRIu64, (uint64_t)prefix_count());
     add_stat("curr_prefixes", 13, val, len, cookie);
 
@@ -634,32 +650,72 @@ void item_stats_global(ADD_STAT add_stat, const void *cookie)
 void item_stats(ADD_STAT add_stat, const void *cookie)
 {
     const char *prefix = "items";
+    itemstats_t sum;
+    unsigned int sizes, sticky_sizes;
+    unsigned int hot_sizes, warm_sizes;
+    rel_time_t age;
+    bool found;
 
-    LOCK_CACHE();
+    LOCK_CACHE_ALL();
     for (int i = 0; i <= POWER_LARGEST; i++) {
-        if (itemsp->tails[i] == NULL && itemsp->sticky_tails[i] == NULL)
+        /* aggregate the LRU stats of all cache partitions */
+        memset(&sum, 0, sizeof(sum));
+        sizes = sticky_sizes = 0;
+        hot_sizes = warm_sizes = 0;
+        age = 0;
+        found = false;
+        for (int p = 0; p < engine->cache_part_count; p++) {
+            struct items *itemsp = &engine->cache_parts[p].items;
+            if (itemsp->sizes[i] > 0 || itemsp->sticky_tails[i] != NULL) {
+                found = true;
+            }
+            sizes += itemsp->sizes[i];
+            hot_sizes += itemsp->hot_sizes[i];
+            warm_sizes += itemsp->warm_sizes[i];
+            sticky_sizes += itemsp->sticky_sizes[i];
+            hash_item *tail = (itemsp->tails[i] != NULL ? itemsp->tails[i]
+                             : itemsp->warm_tails[i] != NULL ? itemsp->warm_tails[i]
+                             : itemsp->hot_tails[i]);
+            if (tail != NULL && (age == 0 || tail->time < age)) {
+                age = tail->time; /* the oldest one */
+            }
+            sum.evicted += itemsp->itemstats[i].evicted;
+            sum.evicted_nonzero += itemsp->itemstats[i].evicted_nonzero;
+            if (sum.evicted_time < itemsp->itemstats[i].evicted_time) {
+                sum.evicted_time = itemsp->itemstats[i].evicted_time;
+            }
+            sum.outofmemory += itemsp->itemstats[i].outofmemory;
+            sum.tailrepairs += itemsp->itemstats[i].tailrepairs;
+            sum.reclaimed += itemsp->itemstats[i].reclaimed;
+        }
+        if (!found)
             continue;
 
         add_statistics(cookie, add_stat, prefix, i, "number", "%u",
-                       itemsp->sizes[i]+itemsp->sticky_sizes[i]);
+                       sizes+sticky_sizes);
 #ifdef ENABLE_STICKY_ITEM
         add_statistics(cookie, add_stat, prefix, i, "sticky", "%u",
-                       itemsp->sticky_sizes[i]);
+                       sticky_sizes);
 #endif
-        add_statistics(cookie, add_stat, prefix, i, "age", "%u",
-                       (itemsp->tails[i] != NULL ? itemsp->tails[i]->time : 0));
+        add_statistics(cookie, add_stat, prefix, i, "number_hot", "%u",
+                       hot_sizes);
+        add_statistics(cookie, add_stat, prefix, i, "number_warm", "%u",
+                       warm_sizes);
+        add_statistics(cookie, add_stat, prefix, i, "number_cold", "%u",
+                       sizes - hot_sizes - warm_sizes);
+        add_statistics(cookie, add_stat, prefix, i, "age", "%u", age);
         add_statistics(cookie, add_stat, prefix, i, "evicted",
-                       "%u", itemsp->itemstats[i].evicted);
+                       "%u", sum.evicted);
         add_statistics(cookie, add_stat, prefix, i, "evicted_nonzero",
-                       "%u", itemsp->itemstats[i].evicted_nonzero);
+                       "%u", sum.evicted_nonzero);
         add_statistics(cookie, add_stat, prefix, i, "evicted_time",
-                       "%u", itemsp->itemstats[i].evicted_time);
+                       "%u", sum.evicted_time);
         add_statistics(cookie, add_stat, prefix, i, "outofmemory",
-                       "%u", itemsp->itemstats[i].outofmemory);
+                       "%u", sum.outofmemory);
         add_statistics(cookie, add_stat, prefix, i, "tailrepairs",
-                       "%u", itemsp->itemstats[i].tailrepairs);
+                       "%u", sum.tailrepairs);
         add_statistics(cookie, add_stat, prefix, i, "reclaimed",
-                       "%u", itemsp->itemstats[i].reclaimed);
+                       "%u", sum.reclaimed);
     }
     UNLOCK_CACHE();
 }
@@ -683,7 +739,7 @@ void item_stats_sizes(ADD_STAT add_stat, const void *cookie)
         int i;
 
         /* build the histogram */
-        LOCK_CACHE();
+        LOCK_CACHE_ALL();
         for (i = 0; i <= POWER_LARGEST; i++) {
             hash_item *iter = itemsp->heads[i];
             while (iter) {
@@ -725,7 +781,7 @@ void item_stats_sizes(ADD_STAT add_stat, const void *cookie)
 
 void item_stats_reset(void)
 {
-    LOCK_CACHE();
+    LOCK_CACHE_ALL();
     do_item_stat_reset();
     UNLOCK_CACHE();
 }
@@ -779,7 +835,7 @@ ENGINE_ERROR_CODE item_getattr(const void *key, const uint32_t nkey,
     hash_item *it;
     ENGINE_ERROR_CODE ret;
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     it = do_item_get(key, nkey, DO_UPDATE);
     if (it == NULL) {
         ret = ENGINE_KEY_ENOENT;
@@ -863,7 +919,7 @@ ENGINE_ERROR_CODE item_setattr(const void *key, const uint32_t nkey,
     ENGINE_ERROR_CODE ret;
     PERSISTENCE_ACTION_BEGIN(cookie, UPD_SETATTR_EXPTIME);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     it = do_item_get(key, nkey, DONT_UPDATE);
     if (it == NULL) {
         ret = ENGINE_KEY_ENOENT;
@@ -939,7 +995,7 @@ ENGINE_ERROR_CODE coll_elem_get_all(hash_item *it, elems_result_t *eresult, bool
     coll_meta_info *info;
     ENGINE_ERROR_CODE ret = ENGINE_SUCCESS;
 
-    if (lock_hold) LOCK_CACHE();
+    if (lock_hold) LOCK_CACHE(it->khash);
     do {
         if (!IS_COLL_ITEM(it)) {
             ret = ENGINE_EBADTYPE; break;
@@ -990,7 +1046,7 @@ void coll_elem_result_release(elems_result_t *eresult, int type)
 bool item_conf_get_evict_to_free(void)
 {
     bool value;
-    LOCK_CACHE();
+    LOCK_CACHE_ALL();
     value = config->evict_to_free;
     UNLOCK_CACHE();
     return value;
@@ -998,7 +1054,7 @@ bool item_conf_get_evict_to_free(void)
 
 void item_conf_set_evict_to_free(bool value)
 {
-    LOCK_CACHE();
+    LOCK_CACHE_ALL();
     config->evict_to_free = value;
     UNLOCK_CACHE();
 }
@@ -1012,7 +1068,7 @@ void item_conf_set_evict_to_free(bool value)
 
 void item_scan_open(item_scan *sp, const char *prefix, const int nprefix, CB_SCAN_OPEN cb_scan_open)
 {
-    LOCK_CACHE();
+    LOCK_CACHE_ALL();
     assoc_scan_init(&sp->asscan);
     if (cb_scan_open != NULL) {
         cb_scan_open(&sp->asscan);
@@ -1028,7 +1084,7 @@ int item_scan_direct(const char *cursor, ENGINE_ITEM_TYPE type, int req_count, v
 {
     hash_item *it;
 
-    LOCK_CACHE();
+    LOCK_CACHE_ALL();
     int item_count = assoc_scan_direct(cursor, req_count, (hash_item**)item_array, item_arrsz);
     if (item_count > 0) {
         rel_time_t curtime = svcore->get_current_time();
@@ -1071,7 +1127,7 @@ int item_scan_getnext(item_scan *sp, void **item_array, elems_result_t *erst_arr
     int item_count;
     ENGINE_ERROR_CODE ret = ENGINE_SUCCESS;
 
-    LOCK_CACHE();
+    LOCK_CACHE_ALL();
     item_count = assoc_scan_next(&sp->asscan, (hash_item**)item_array, item_limit, elem_limit);
     if (item_count > 0) {
         rel_time_t curtime = svcore->get_current_time();
@@ -1134,11 +1190,12 @@ void item_scan_release(item_scan *sp, void **item_array, elems_result_t *erst_ar
         }
     }
 
-    LOCK_CACHE();
     for (int i = 0; i < item_count; i++) {
-        do_item_release(item_array[i]);
+        hash_item *it = (hash_item *)item_array[i];
+        LOCK_CACHE(it->khash);
+        do_item_release(it);
+        UNLOCK_CACHE();
     }
-    UNLOCK_CACHE();
 }
 
 void item_scan_close(item_scan *sp, CB_SCAN_CLOSE cb_scan_close, bool success)
@@ -1147,7 +1204,7 @@ void item_scan_close(item_scan *sp, CB_SCAN_CLOSE cb_scan_close, bool success)
     sp->nprefix = 0;
     sp->is_used = false;
 
-    LOCK_CACHE();
+    LOCK_CACHE_ALL();
     assoc_scan_final(&sp->asscan);
     if (cb_scan_close != NULL) {
         cb_scan_close(success);
@@ -1185,7 +1242,7 @@ static void *item_scrubber_main(void *arg)
     assert(scrubber->running == true);
 
 again:
-    LOCK_CACHE();
+    LOCK_CACHE_ALL();
     assoc_scan_init(&scan);
     while (engine->initialized && !scrubber->restart) {
         /* scan and scrub cache items */
@@ -1216,7 +1273,7 @@ again:
             nanosleep(&sleep_time, NULL); /* 64 usec */
             scan_execs = 0;
         }
-        TRYLOCK_CACHE(5);
+        LOCK_CACHE_ALL();
     }
     assoc_scan_final(&scan);
     UNLOCK_CACHE();
@@ -1729,7 +1786,7 @@ ENGINE_ERROR_CODE item_apply_kv_link(void *engine, const char *key, const uint32
                 "item_apply_kv_link. key=%.*s nkey=%u nbytes=%u\n",
                 PRINT_NKEY(nkey), key, nkey, nbytes);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     old_it = do_item_get(key, nkey, DONT_UPDATE);
     new_it = do_item_alloc(key, nkey, flags, exptime, nbytes, NULL); /* cookie is NULL */
     if (new_it) {
@@ -1774,7 +1831,7 @@ ENGINE_ERROR_CODE item_apply_unlink(void *engine, const char *key, const uint32_
     logger->log(ITEM_APPLY_LOG_LEVEL, NULL, "item_apply_unlink. key=%.*s nkey=%u\n",
                 PRINT_NKEY(nkey), key, nkey);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     it = do_item_get(key, nkey, DONT_UPDATE);
     if (it) {
         do_item_unlink(it, ITEM_UNLINK_NORMAL); /* must unlink first. */
@@ -1802,7 +1859,7 @@ ENGINE_ERROR_CODE item_apply_setattr_exptime(void *engine, const char *key, cons
     logger->log(ITEM_APPLY_LOG_LEVEL, NULL, "item_apply_setattr_exptime. key=%.*s nkey=%u\n",
                 PRINT_NKEY(nkey), key, nkey);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     it = do_item_get(key, nkey, DONT_UPDATE);
     if (it) {
         it->exptime = exptime;
@@ -1829,7 +1886,7 @@ ENGINE_ERROR_CODE item_apply_setattr_collinfo(void *engine, hash_item *it,
     logger->log(ITEM_APPLY_LOG_LEVEL, NULL, "item_apply_setattr_collinfo. key=%.*s nkey=%u\n",
                 PRINT_NKEY(it->nkey), key, it->nkey);
 
-    LOCK_CACHE();
+    LOCK_CACHE(it->khash);
     do {
         if (!item_is_valid(it)) {
             logger->log(EXTENSION_LOG_WARNING, NULL, "item_apply_setattr_collinfo failed."
@@ -1875,7 +1932,7 @@ ENGINE_ERROR_CODE item_apply_lru_update(void *engine, const char *key, const uin
     logger->log(ITEM_APPLY_LOG_LEVEL, NULL, "item_apply_lru_update. key=%.*s nkey=%u\n",
                 PRINT_NKEY(nkey), key, nkey);
 
-    LOCK_CACHE();
+    LOCK_CACHE(item_key_hash(key, nkey));
     it = do_item_get(key, nkey, DONT_UPDATE);
     if (it) {
         do_item_update(it, true); /* force the LRU update */
@@ -1894,7 +1951,7 @@ ENGINE_ERROR_CODE item_apply_flush(void *engine, const char *prefix, const int n
     logger->log(ITEM_APPLY_LOG_LEVEL, NULL, "item_apply_flush. prefix=%s nprefix=%d\n",
                 prefix ? prefix : "<null>", nprefix);
 
-    LOCK_CACHE();
+    LOCK_CACHE_ALL();
     ret = do_item_flush_expired(prefix, nprefix, 0 /* right now */, NULL);
     UNLOCK_CACHE();
     return ret;
@@ -1905,7 +1962,6 @@ ENGINE_ERROR_CODE item_init(struct default_engine *engine_ptr)
     /* initialize global variables */
     engine = engine_ptr;
     config = &engine->config;
-    itemsp = &engine->items;
     svcore = engine->server.core;
     logger = engine->server.log->get_logger();
 
@@ -1939,7 +1995,7 @@ ENGINE_ERROR_CODE item_init(struct default_engine *engine_ptr)
 
 void item_final(struct default_engine *engine_ptr)
 {
-    if (itemsp == NULL) {
+    if (engine == NULL) {
         return; /* nothing to do */
     }
 
@@ -46,17 +46,24 @@ static SERVER_CORE_API      *svcore=NULL; // server core api
 static EXTENSION_LOGGER_DESCRIPTOR *logger;
 static prefix_t *null_pt = NULL; /* null prefix info */
 
-#ifdef SCAN_COMMAND
-static inline void LOCK_CACHE(void)
+/* The prefix hash table is protected by the prefix lock.
+ * The item count and bytes of a prefix are updated atomically,
+ * since the items of a prefix are spread over the cache partitions.
+ */
+#define PREFIX_STAT_ADD(var, val) ((void)__sync_add_and_fetch(&(var), (val)))
+#define PREFIX_STAT_SUB(var, val) ((void)__sync_sub_and_fetch(&(var), (val)))
+
+static inline void LOCK_PREFIX(void)
 {
-    pthread_mutex_lock(&engine->cache_lock);
+    pthread_mutex_lock(&prefxp->lock);
 }
 
-static inline void UNLOCK_CACHE(void)
+static inline void UNLOCK_PREFIX(void)
 {
-    pthread_mutex_unlock(&engine->cache_lock);
+    pthread_mutex_unlock(&prefxp->lock);
 }
 
+#ifdef SCAN_COMMAND
 static inline void PREFIX_REFCOUNT_INCR(prefix_t *pt)
 {
     if (pt != null_pt) {
@@ -90,6 +97,7 @@ ENGINE_ERROR_CODE prefix_init(struct default_engine *engine_ptr)
     }
     memset(&prefxp->null_prefix_data, 0, sizeof(prefix_t));
     prefxp->total_prefix_items = 0;
+    pthread_mutex_init(&prefxp->lock, NULL);
 
     /* set the null prefix pointer */
     null_pt = &prefxp->null_prefix_data;
@@ -105,6 +113,7 @@ void prefix_final(struct default_engine *engine)
             free(prefxp->hashtable);
             prefxp->hashtable = NULL;
         }
+        pthread_mutex_destroy(&prefxp->lock);
     }
     logger->log(EXTENSION_LOG_INFO, NULL, "PREFIX module destroyed.\n");
 }
@@ -114,6 +123,15 @@ static inline void *_get_prefix(prefix_t *prefix)
     return (void*)(prefix + 1);
 }
 
+static void _prefix_free(prefix_t *pt)
+{
+    /* The lock-free readers might check the validity of the prefix.
+     * See item_get_lockfree().
+     */
+    item_read_synchronize();
+    free(pt);
+}
+
 static prefix_t *_prefix_find(const char *prefix, const int nprefix, uint32_t hash)
 {
     prefix_t *pt = prefxp->hashtable[hash & hashmask(DEFAULT_PREFIX_HASHPOWER)];
@@ -149,25 +167,25 @@ static void _prefix_inclusive_stats_init(prefix_t* pt, bool isleaf)
 static void _prefix_item_count_incr(prefix_t *pt, ENGINE_ITEM_TYPE item_type,
                                     const uint32_t item_size)
 {
-    pt->items_count_exclusive[item_type] += 1;
-    pt->items_bytes_exclusive[item_type] += item_size;
-    pt->total_count_exclusive += 1;
-    pt->total_bytes_exclusive += item_size;
+    PREFIX_STAT_ADD(pt->items_count_exclusive[item_type], 1);
+    PREFIX_STAT_ADD(pt->items_bytes_exclusive[item_type], item_size);
+    PREFIX_STAT_ADD(pt->total_count_exclusive, 1);
+    PREFIX_STAT_ADD(pt->total_bytes_exclusive, item_size);
 
 #ifdef NESTED_PREFIX
     if (pt->child_prefix_items > 0) {
-        pt->items_count_inclusive[item_type] += 1;
-        pt->items_bytes_inclusive[item_type] += item_size;
-        pt->total_count_inclusive += 1;
-        pt->total_bytes_inclusive += item_size;
+        PREFIX_STAT_ADD(pt->items_count_inclusive[item_type], 1);
+        PREFIX_STAT_ADD(pt->items_bytes_inclusive[item_type], item_size);
+        PREFIX_STAT_ADD(pt->total_count_inclusive, 1);
+        PREFIX_STAT_ADD(pt->total_bytes_inclusive, item_size);
     }
 
     prefix_t *parent_pt = pt->parent_prefix;
     while (parent_pt != NULL) {
-        parent_pt->items_count_inclusive[item_type] += 1;
-        parent_pt->items_bytes_inclusive[item_type] += item_size;
-        parent_pt->total_count_inclusive += 1;
-        parent_pt->total_bytes_inclusive += item_size;
+        PREFIX_STAT_ADD(parent_pt->items_count_inclusive[item_type], 1);
+        PREFIX_STAT_ADD(parent_pt->items_bytes_inclusive[item_type], item_size);
+        PREFIX_STAT_ADD(parent_pt->total_count_inclusive, 1);
+        PREFIX_STAT_ADD(parent_pt->total_bytes_inclusive, item_size);
         parent_pt = parent_pt->parent_prefix;
     }
 #endif
@@ -176,25 +194,25 @@ static void _prefix_item_count_incr(prefix_t *pt, ENGINE_ITEM_TYPE item_type,
 static void _prefix_item_count_decr(prefix_t *pt, ENGINE_ITEM_TYPE item_type,
                                     const uint32_t item_size)
 {
-    pt->items_count_exclusive[item_type] -= 1;
-    pt->items_bytes_exclusive[item_type] -= item_size;
-    pt->total_count_exclusive -= 1;
-    pt->total_bytes_exclusive -= item_size;
+    PREFIX_STAT_SUB(pt->items_count_exclusive[item_type], 1);
+    PREFIX_STAT_SUB(pt->items_bytes_exclusive[item_type], item_size);
+    PREFIX_STAT_SUB(pt->total_count_exclusive, 1);
+    PREFIX_STAT_SUB(pt->total_bytes_exclusive, item_size);
 
 #ifdef NESTED_PREFIX
     if (pt->child_prefix_items > 0) {
-        pt->items_count_inclusive[item_type] -= 1;
-        pt->items_bytes_inclusive[item_type] -= item_size;
-        pt->total_count_inclusive -= 1;
-        pt->total_bytes_inclusive -= item_size;
+        PREFIX_STAT_SUB(pt->items_count_inclusive[item_type], 1);
+        PREFIX_STAT_SUB(pt->items_bytes_inclusive[item_type], item_size);
+        PREFIX_STAT_SUB(pt->total_count_inclusive, 1);
+        PREFIX_STAT_SUB(pt->total_bytes_inclusive, item_size);
     }
 
     prefix_t *parent_pt = pt->parent_prefix;
     while (parent_pt != NULL) {
-        parent_pt->items_count_inclusive[item_type] -= 1;
-        parent_pt->items_bytes_inclusive[item_type] -= item_size;
-        parent_pt->total_count_inclusive -= 1;
-        parent_pt->total_bytes_inclusive -= item_size;
+        PREFIX_STAT_SUB(parent_pt->items_count_inclusive[item_type], 1);
+        PREFIX_STAT_SUB(parent_pt->items_bytes_inclusive[item_type], item_size);
+        PREFIX_STAT_SUB(parent_pt->total_count_inclusive, 1);
+        PREFIX_STAT_SUB(parent_pt->total_bytes_inclusive, item_size);
         parent_pt = parent_pt->parent_prefix;
     }
 #endif
@@ -203,19 +221,19 @@ static void _prefix_item_count_decr(prefix_t *pt, ENGINE_ITEM_TYPE item_type,
 static void _prefix_item_bytes_incr(prefix_t *pt, ENGINE_ITEM_TYPE item_type,
                                     const uint32_t item_bytes)
 {
-    pt->items_bytes_exclusive[item_type] += item_bytes;
-    pt->total_bytes_exclusive += item_bytes;
+    PREFIX_STAT_ADD(pt->items_bytes_exclusive[item_type], item_bytes);
+    PREFIX_STAT_ADD(pt->total_bytes_exclusive, item_bytes);
 
 #ifdef NESTED_PREFIX
     if (pt->child_prefix_items > 0) {
-        pt->items_bytes_inclusive[item_type] += item_bytes;
-        pt->total_bytes_inclusive += item_bytes;
+        PREFIX_STAT_ADD(pt->items_bytes_inclusive[item_type], item_bytes);
+        PREFIX_STAT_ADD(pt->total_bytes_inclusive, item_bytes);
     }
 
     prefix_t *parent_pt = pt->parent_prefix;
     while (parent_pt != NULL) {
-        parent_pt->items_bytes_inclusive[item_type] += item_bytes;
-        parent_pt->total_bytes_inclusive += item_bytes;
+        PREFIX_STAT_ADD(parent_pt->items_bytes_inclusive[item_type], item_bytes);
+        PREFIX_STAT_ADD(parent_pt->total_bytes_inclusive, item_bytes);
         parent_pt = parent_pt->parent_prefix;
     }
 #endif
@@ -224,19 +242,19 @@ static void _prefix_item_bytes_incr(prefix_t *pt, ENGINE_ITEM_TYPE item_type,
 static void _prefix_item_bytes_decr(prefix_t *pt, ENGINE_ITEM_TYPE item_type,
                                     const uint32_t item_bytes)
 {
-    pt->items_bytes_exclusive[item_type] -= item_bytes;
-    pt->total_bytes_exclusive -= item_bytes;
+    PREFIX_STAT_SUB(pt->items_bytes_exclusive[item_type], item_bytes);
+    PREFIX_STAT_SUB(pt->total_bytes_exclusive, item_bytes);
 
 #ifdef NESTED_PREFIX
     if (pt->child_prefix_items > 0) {
-        pt->items_bytes_inclusive[item_type] -= item_bytes;
-        pt->total_bytes_inclusive -= item_bytes;
+        PREFIX_STAT_SUB(pt->items_bytes_inclusive[item_type], item_bytes);
+        PREFIX_STAT_SUB(pt->total_bytes_inclusive, item_bytes);
     }
 
     prefix_t *parent_pt = pt->parent_prefix;
     while (parent_pt != NULL) {
-        parent_pt->items_bytes_inclusive[item_type] -= item_bytes;
-        parent_pt->total_bytes_inclusive -= item_bytes;
+        PREFIX_STAT_SUB(parent_pt->items_bytes_inclusive[item_type], item_bytes);
+        PREFIX_STAT_SUB(parent_pt->total_bytes_inclusive, item_bytes);
         parent_pt = parent_pt->parent_prefix;
     }
 #endif
@@ -304,10 +322,10 @@ static void _prefix_delete(const char *prefix, const int nprefix, uint32_t hash)
 #ifdef SCAN_COMMAND
         pt->islinked = 0;
         if (pt->refcount == 0) {
-            free(pt);
+            _prefix_free(pt);
         }
 #else
-        free(pt);
+        _prefix_free(pt);
 #endif
 
 #ifdef NEW_PREFIX_STATS_MANAGEMENT
@@ -318,17 +336,22 @@ static void _prefix_delete(const char *prefix, const int nprefix, uint32_t hash)
 
 prefix_t *prefix_find(const char *prefix, const int nprefix)
 {
+    prefix_t *pt;
+
     if (nprefix < 0) {
         return NULL;
     }
     if (nprefix > 0) {
-        return _prefix_find(prefix, nprefix, svcore->hash(prefix, nprefix, 0));
+        LOCK_PREFIX();
+        pt = _prefix_find(prefix, nprefix, svcore->hash(prefix, nprefix, 0));
+        UNLOCK_PREFIX();
     } else {
-        return &prefxp->null_prefix_data; /* null prefix */
+        pt = &prefxp->null_prefix_data; /* null prefix */
     }
+    return pt;
 }
 
-ENGINE_ERROR_CODE prefix_link(hash_item *it, const uint32_t item_size, bool *internal)
+static ENGINE_ERROR_CODE do_prefix_link(hash_item *it, const uint32_t item_size, bool *internal)
 {
     const char *key = item_get_key(it);
     uint32_t   nkey = it->nkey;
@@ -430,12 +453,23 @@ ENGINE_ERROR_CODE prefix_link(hash_item *it, const uint32_t item_size, bool *int
     return ENGINE_SUCCESS;
 }
 
+ENGINE_ERROR_CODE prefix_link(hash_item *it, const uint32_t item_size, bool *internal)
+{
+    ENGINE_ERROR_CODE ret;
+
+    LOCK_PREFIX();
+    ret = do_prefix_link(it, item_size, internal);
+    UNLOCK_PREFIX();
+    return ret;
+}
+
 void prefix_unlink(hash_item *it, const uint32_t item_size, bool drop_if_empty)
 {
     prefix_t *pt = it->pfxptr;
     it->pfxptr = NULL;
     assert(pt != NULL);
 
+    LOCK_PREFIX();
     /* update item stats in prefix */
     _prefix_item_count_decr(pt, GET_ITEM_TYPE(it), item_size);
 
@@ -450,6 +484,7 @@ void prefix_unlink(hash_item *it, const uint32_t item_size, bool drop_if_empty)
             pt = parent_pt;
         }
     }
+    UNLOCK_PREFIX();
 }
 
 /* if prefix has child prefixes */
@@ -535,10 +570,12 @@ static uint32_t do_count_invalid_prefix(void)
 
 uint32_t prefix_count(void)
 {
+    LOCK_PREFIX();
     int prefix_cnt = prefxp->total_prefix_items;
     if (null_pt->total_count_exclusive > 0) {
         prefix_cnt += 1;
     }
+    UNLOCK_PREFIX();
     return prefix_cnt;
 }
 
@@ -597,7 +634,7 @@ static int _prefix_stats_write_buffer(char *buffer, const size_t buflen,
     return ret;
 }
 
-char *prefix_dump_stats(token_t *tokens, const size_t ntokens, int *length)
+static char *do_prefix_dump_stats(token_t *tokens, const size_t ntokens, int *length)
 {
     const char *format = "PREFIX %s "
                          "itm %llu kitm %llu litm %llu sitm %llu mitm %llu bitm %llu " /* total item count */
@@ -705,6 +742,16 @@ char *prefix_dump_stats(token_t *tokens, const size_t ntokens, int *length)
     return buffer;
 }
 
+char *prefix_dump_stats(token_t *tokens, const size_t ntokens, int *length)
+{
+    char *stats;
+
+    LOCK_PREFIX();
+    stats = do_prefix_dump_stats(tokens, ntokens, length);
+    UNLOCK_PREFIX();
+    return stats;
+}
+
 #ifdef SCAN_COMMAND
 static bool _prefix_isempty(prefix_t *pt)
 {
@@ -756,21 +803,21 @@ static int _prefix_scan_direct(const char *cursor, int req_count, void **item_ar
 int prefix_scan_direct(const char *cursor, int req_count, void **item_array, int item_arrsz)
 {
     assert(item_arrsz > 0 && req_count <= item_arrsz);
-    LOCK_CACHE();
+    LOCK_PREFIX();
     int item_count = _prefix_scan_direct(cursor, req_count, item_array, item_arrsz);
-    UNLOCK_CACHE();
+    UNLOCK_PREFIX();
     return item_count;
 }
 
 void prefix_release(prefix_t *pt)
 {
     if (pt != null_pt) {
-        LOCK_CACHE();
+        LOCK_PREFIX();
         PREFIX_REFCOUNT_DECR(pt);
         if (pt->refcount == 0 && pt->islinked == 0) {
-            free(pt);
+            _prefix_free(pt);
         }
-        UNLOCK_CACHE();
+        UNLOCK_PREFIX();
     }
 }
 
@@ -65,6 +65,9 @@ struct prefix {
 
     /* Number of prefix items in hash table */
     uint32_t total_prefix_items;
+
+    /* prefix lock */
+    pthread_mutex_t lock;
 };
 
 /* prefix functions */
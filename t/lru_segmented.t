@@ -0,0 +1,51 @@
+#!/usr/bin/perl
+# Test the segmented LRU: the items read more than once are kept
+# in the WARM segment and survive the evictions of one-time items.
+
+use strict;
+use Test::More tests => 9;
+use FindBin qw($Bin);
+use lib "$Bin/lib";
+use MemcachedTest;
+
+my $engine = shift;
+my $server = get_memcached($engine, "-m 10");
+my $sock = $server->sock;
+my $cmd;
+my $val = "B"x2000;
+my $rst;
+my $msg;
+
+# hot item: read twice to become active
+$cmd = "set hotkey 0 0 2000"; $rst = "STORED"; $msg = "stored hotkey";
+mem_cmd_is($sock, $cmd, $val, $rst, $msg);
+$cmd = "get hotkey"; $rst = "VALUE hotkey 0 2000\n$val\nEND";
+mem_cmd_is($sock, $cmd, "", $rst);
+mem_cmd_is($sock, $cmd, "", $rst);
+
+# cold item: read only once
+$cmd = "set coldkey 0 0 2000"; $rst = "STORED"; $msg = "stored coldkey";
+mem_cmd_is($sock, $cmd, $val, $rst, $msg);
+$cmd = "get coldkey"; $rst = "VALUE coldkey 0 2000\n$val\nEND";
+mem_cmd_is($sock, $cmd, "", $rst);
+
+# one-time items, enough to get evictions
+my $stored = 0;
+for (my $i = 0; $i < 20000; $i++) {
+    print $sock "set key$i 0 0 2000\r\n$val\r\n";
+    my $line = <$sock>;
+    $stored++ if ($line eq "STORED\r\n");
+}
+is($stored, 20000, "stored one-time items");
+
+my $stats = mem_stats($sock);
+isnt($stats->{"evictions"}, "0", "some evictions happened");
+
+# the hot item is kept, the cold one is evicted
+$cmd = "get hotkey"; $rst = "VALUE hotkey 0 2000\n$val\nEND";
+mem_cmd_is($sock, $cmd, "", $rst, "hotkey kept");
+$cmd = "get coldkey"; $rst = "END";
+mem_cmd_is($sock, $cmd, "", $rst, "coldkey evicted");
+
+# after test
+release_memcached($engine, $server);
@@ -652,139 +652,139 @@ int is_listen_thread(void)
 
 void threadlocal_stats_clear(struct thread_stats *stats)
 {
-    stats->cmd_get = 0;
-    stats->cmd_set = 0;
-    stats->cmd_incr = 0;
-    stats->cmd_decr = 0;
-    stats->cmd_delete = 0;
-    stats->get_hits = 0;
-    stats->get_misses = 0;
-    stats->incr_hits = 0;
-    stats->incr_misses = 0;
-    stats->decr_hits = 0;
-    stats->decr_misses = 0;
-    stats->delete_hits = 0;
-    stats->delete_misses = 0;
-    stats->cmd_cas = 0;
-    stats->cas_hits = 0;
-    stats->cas_badval = 0;
-    stats->cas_misses = 0;
-    stats->cmd_flush = 0;
-    stats->cmd_flush_prefix = 0;
-    stats->cmd_auth = 0;
-    stats->auth_errors = 0;
-    stats->bytes_written = 0;
-    stats->bytes_read = 0;
-    stats->conn_yields = 0;
+    THREAD_STATS_STORE(stats->cmd_get, 0);
+    THREAD_STATS_STORE(stats->cmd_set, 0);
+    THREAD_STATS_STORE(stats->cmd_incr, 0);
+    THREAD_STATS_STORE(stats->cmd_decr, 0);
+    THREAD_STATS_STORE(stats->cmd_delete, 0);
+    THREAD_STATS_STORE(stats->get_hits, 0);
+    THREAD_STATS_STORE(stats->get_misses, 0);
+    THREAD_STATS_STORE(stats->incr_hits, 0);
+    THREAD_STATS_STORE(stats->incr_misses, 0);
+    THREAD_STATS_STORE(stats->decr_hits, 0);
+    THREAD_STATS_STORE(stats->decr_misses, 0);
+    THREAD_STATS_STORE(stats->delete_hits, 0);
+    THREAD_STATS_STORE(stats->delete_misses, 0);
+    THREAD_STATS_STORE(stats->cmd_cas, 0);
+    THREAD_STATS_STORE(stats->cas_hits, 0);
+    THREAD_STATS_STORE(stats->cas_badval, 0);
+    THREAD_STATS_STORE(stats->cas_misses, 0);
+    THREAD_STATS_STORE(stats->cmd_flush, 0);
+    THREAD_STATS_STORE(stats->cmd_flush_prefix, 0);
+    THREAD_STATS_STORE(stats->cmd_auth, 0);
+    THREAD_STATS_STORE(stats->auth_errors, 0);
+    THREAD_STATS_STORE(stats->bytes_written, 0);
+    THREAD_STATS_STORE(stats->bytes_read, 0);
+    THREAD_STATS_STORE(stats->conn_yields, 0);
     /* list command stats */
-    stats->cmd_lop_create = 0;
-    stats->cmd_lop_insert = 0;
-    stats->cmd_lop_delete = 0;
-    stats->cmd_lop_get = 0;
-    stats->lop_create_oks = 0;
-    stats->lop_insert_hits = 0;
-    stats->lop_insert_misses = 0;
-    stats->lop_delete_elem_hits = 0;
-    stats->lop_delete_none_hits = 0;
-    stats->lop_delete_misses = 0;
-    stats->lop_get_elem_hits = 0;
-    stats->lop_get_none_hits = 0;
-    stats->lop_get_misses = 0;
+    THREAD_STATS_STORE(stats->cmd_lop_create, 0);
+    THREAD_STATS_STORE(stats->cmd_lop_insert, 0);
+    THREAD_STATS_STORE(stats->cmd_lop_delete, 0);
+    THREAD_STATS_STORE(stats->cmd_lop_get, 0);
+    THREAD_STATS_STORE(stats->lop_create_oks, 0);
+    THREAD_STATS_STORE(stats->lop_insert_hits, 0);
+    THREAD_STATS_STORE(stats->lop_insert_misses, 0);
+    THREAD_STATS_STORE(stats->lop_delete_elem_hits, 0);
+    THREAD_STATS_STORE(stats->lop_delete_none_hits, 0);
+    THREAD_STATS_STORE(stats->lop_delete_misses, 0);
+    THREAD_STATS_STORE(stats->lop_get_elem_hits, 0);
+    THREAD_STATS_STORE(stats->lop_get_none_hits, 0);
+    THREAD_STATS_STORE(stats->lop_get_misses, 0);
     /* set command stats */
-    stats->cmd_sop_create = 0;
-    stats->cmd_sop_insert = 0;
-    stats->cmd_sop_delete = 0;
-    stats->cmd_sop_get = 0;
-    stats->cmd_sop_exist = 0;
-    stats->sop_create_oks = 0;
-    stats->sop_insert_hits = 0;
-    stats->sop_insert_misses = 0;
-    stats->sop_delete_elem_hits = 0;
-    stats->sop_delete_none_hits = 0;
-    stats->sop_delete_misses = 0;
-    stats->sop_get_elem_hits = 0;
-    stats->sop_get_none_hits = 0;
-    stats->sop_get_misses = 0;
-    stats->sop_exist_hits = 0;
-    stats->sop_exist_misses = 0;
+    THREAD_STATS_STORE(stats->cmd_sop_create, 0);
+    THREAD_STATS_STORE(stats->cmd_sop_insert, 0);
+    THREAD_STATS_STORE(stats->cmd_sop_delete, 0);
+    THREAD_STATS_STORE(stats->cmd_sop_get, 0);
+    THREAD_STATS_STORE(stats->cmd_sop_exist, 0);
+    THREAD_STATS_STORE(stats->sop_create_oks, 0);
+    THREAD_STATS_STORE(stats->sop_insert_hits, 0);
+    THREAD_STATS_STORE(stats->sop_insert_misses, 0);
+    THREAD_STATS_STORE(stats->sop_delete_elem_hits, 0);
+    THREAD_STATS_STORE(stats->sop_delete_none_hits, 0);
+    THREAD_STATS_STORE(stats->sop_delete_misses, 0);
+    THREAD_STATS_STORE(stats->sop_get_elem_hits, 0);
+    THREAD_STATS_STORE(stats->sop_get_none_hits, 0);
+    THREAD_STATS_STORE(stats->sop_get_misses, 0);
+    THREAD_STATS_STORE(stats->sop_exist_hits, 0);
+    THREAD_STATS_STORE(stats->sop_exist_misses, 0);
     /* map command stats */
-    stats->cmd_mop_create = 0;
-    stats->cmd_mop_insert = 0;
-    stats->cmd_mop_update = 0;
-    stats->cmd_mop_delete = 0;
-    stats->cmd_mop_get = 0;
-    stats->mop_create_oks = 0;
-    stats->mop_insert_hits = 0;
-    stats->mop_insert_misses = 0;
-    stats->mop_update_elem_hits = 0;
-    stats->mop_update_none_hits = 0;
-    stats->mop_update_misses = 0;
-    stats->mop_delete_elem_hits = 0;
-    stats->mop_delete_none_hits = 0;
-    stats->mop_delete_misses = 0;
-    stats->mop_get_elem_hits = 0;
-    stats->mop_get_none_hits = 0;
-    stats->mop_get_misses = 0;
+    THREAD_STATS_STORE(stats->cmd_mop_create, 0);
+    THREAD_STATS_STORE(stats->cmd_mop_insert, 0);
+    THREAD_STATS_STORE(stats->cmd_mop_update, 0);
+    THREAD_STATS_STORE(stats->cmd_mop_delete, 0);
+    THREAD_STATS_STORE(stats->cmd_mop_get, 0);
+    THREAD_STATS_STORE(stats->mop_create_oks, 0);
+    THREAD_STATS_STORE(stats->mop_insert_hits, 0);
+    THREAD_STATS_STORE(stats->mop_insert_misses, 0);
+    THREAD_STATS_STORE(stats->mop_update_elem_hits, 0);
+    THREAD_STATS_STORE(stats->mop_update_none_hits, 0);
+    THREAD_STATS_STORE(stats->mop_update_misses, 0);
+    THREAD_STATS_STORE(stats->mop_delete_elem_hits, 0);
+    THREAD_STATS_STORE(stats->mop_delete_none_hits, 0);
+    THREAD_STATS_STORE(stats->mop_delete_misses, 0);
+    THREAD_STATS_STORE(stats->mop_get_elem_hits, 0);
+    THREAD_STATS_STORE(stats->mop_get_none_hits, 0);
+    THREAD_STATS_STORE(stats->mop_get_misses, 0);
     /* btree command stats */
-    stats->cmd_bop_create = 0;
-    stats->cmd_bop_insert = 0;
-    stats->cmd_bop_update = 0;
-    stats->cmd_bop_delete = 0;
-    stats->cmd_bop_get = 0;
-    stats->cmd_bop_count = 0;
-    stats->cmd_bop_position = 0;
-    stats->cmd_bop_pwg = 0;
-    stats->cmd_bop_gbp = 0;
+    THREAD_STATS_STORE(stats->cmd_bop_create, 0);
+    THREAD_STATS_STORE(stats->cmd_bop_insert, 0);
+    THREAD_STATS_STORE(stats->cmd_bop_update, 0);
+    THREAD_STATS_STORE(stats->cmd_bop_delete, 0);
+    THREAD_STATS_STORE(stats->cmd_bop_get, 0);
+    THREAD_STATS_STORE(stats->cmd_bop_count, 0);
+    THREAD_STATS_STORE(stats->cmd_bop_position, 0);
+    THREAD_STATS_STORE(stats->cmd_bop_pwg, 0);
+    THREAD_STATS_STORE(stats->cmd_bop_gbp, 0);
 #ifdef SUPPORT_BOP_MGET
-    stats->cmd_bop_mget = 0;
+    THREAD_STATS_STORE(stats->cmd_bop_mget, 0);
 #endif
 #ifdef SUPPORT_BOP_SMGET
-    stats->cmd_bop_smget = 0;
+    THREAD_STATS_STORE(stats->cmd_bop_smget, 0);
 #endif
-    stats->cmd_bop_incr = 0;
-    stats->cmd_bop_decr = 0;
-    stats->bop_create_oks = 0;
-    stats->bop_insert_hits = 0;
-    stats->bop_insert_misses = 0;
-    stats->bop_update_elem_hits = 0;
-    stats->bop_update_none_hits = 0;
-    stats->bop_update_misses = 0;
-    stats->bop_delete_elem_hits = 0;
-    stats->bop_delete_none_hits = 0;
-    stats->bop_delete_misses = 0;
-    stats->bop_get_elem_hits = 0;
-    stats->bop_get_none_hits = 0;
-    stats->bop_get_misses = 0;
-    stats->bop_count_hits = 0;
-    stats->bop_count_misses = 0;
-    stats->bop_position_elem_hits = 0;
-    stats->bop_position_none_hits = 0;
-    stats->bop_position_misses = 0;
-    stats->bop_pwg_elem_hits = 0;
-    stats->bop_pwg_none_hits = 0;
-    stats->bop_pwg_misses = 0;
-    stats->bop_gbp_elem_hits = 0;
-    stats->bop_gbp_none_hits = 0;
-    stats->bop_gbp_misses = 0;
+    THREAD_STATS_STORE(stats->cmd_bop_incr, 0);
+    THREAD_STATS_STORE(stats->cmd_bop_decr, 0);
+    THREAD_STATS_STORE(stats->bop_create_oks, 0);
+    THREAD_STATS_STORE(stats->bop_insert_hits, 0);
+    THREAD_STATS_STORE(stats->bop_insert_misses, 0);
+    THREAD_STATS_STORE(stats->bop_update_elem_hits, 0);
+    THREAD_STATS_STORE(stats->bop_update_none_hits, 0);
+    THREAD_STATS_STORE(stats->bop_update_misses, 0);
+    THREAD_STATS_STORE(stats->bop_delete_elem_hits, 0);
+    THREAD_STATS_STORE(stats->bop_delete_none_hits, 0);
+    THREAD_STATS_STORE(stats->bop_delete_misses, 0);
+    THREAD_STATS_STORE(stats->bop_get_elem_hits, 0);
+    THREAD_STATS_STORE(stats->bop_get_none_hits, 0);
+    THREAD_STATS_STORE(stats->bop_get_misses, 0);
+    THREAD_STATS_STORE(stats->bop_count_hits, 0);
+    THREAD_STATS_STORE(stats->bop_count_misses, 0);
+    THREAD_STATS_STORE(stats->bop_position_elem_hits, 0);
+    THREAD_STATS_STORE(stats->bop_position_none_hits, 0);
+    THREAD_STATS_STORE(stats->bop_position_misses, 0);
+    THREAD_STATS_STORE(stats->bop_pwg_elem_hits, 0);
+    THREAD_STATS_STORE(stats->bop_pwg_none_hits, 0);
+    THREAD_STATS_STORE(stats->bop_pwg_misses, 0);
+    THREAD_STATS_STORE(stats->bop_gbp_elem_hits, 0);
+    THREAD_STATS_STORE(stats->bop_gbp_none_hits, 0);
+    THREAD_STATS_STORE(stats->bop_gbp_misses, 0);
 #ifdef SUPPORT_BOP_MGET
-    stats->bop_mget_oks = 0;
+    THREAD_STATS_STORE(stats->bop_mget_oks, 0);
 #endif
 #ifdef SUPPORT_BOP_SMGET
-    stats->bop_smget_oks = 0;
+    THREAD_STATS_STORE(stats->bop_smget_oks, 0);
 #endif
-    stats->bop_incr_elem_hits = 0;
-    stats->bop_incr_none_hits = 0;
-    stats->bop_incr_misses = 0;
-    stats->bop_decr_elem_hits = 0;
-    stats->bop_decr_none_hits = 0;
-    stats->bop_decr_misses = 0;
+    THREAD_STATS_STORE(stats->bop_incr_elem_hits, 0);
+    THREAD_STATS_STORE(stats->bop_incr_none_hits, 0);
+    THREAD_STATS_STORE(stats->bop_incr_misses, 0);
+    THREAD_STATS_STORE(stats->bop_decr_elem_hits, 0);
+    THREAD_STATS_STORE(stats->bop_decr_none_hits, 0);
+    THREAD_STATS_STORE(stats->bop_decr_misses, 0);
     /* attribute command stats */
-    stats->cmd_getattr = 0;
-    stats->cmd_setattr = 0;
-    stats->getattr_hits = 0;
-    stats->getattr_misses = 0;
-    stats->setattr_hits = 0;
-    stats->setattr_misses = 0;
+    THREAD_STATS_STORE(stats->cmd_getattr, 0);
+    THREAD_STATS_STORE(stats->cmd_setattr, 0);
+    THREAD_STATS_STORE(stats->getattr_hits, 0);
+    THREAD_STATS_STORE(stats->getattr_misses, 0);
+    THREAD_STATS_STORE(stats->setattr_hits, 0);
+    THREAD_STATS_STORE(stats->setattr_misses, 0);
 }
 
 void *threadlocal_stats_create(int num_threads)
@@ -795,29 +795,24 @@ void *threadlocal_stats_create(int num_threads)
         return NULL; /* invalid argument */
     }
 
-    thread_stats = calloc(sizeof(struct thread_stats) * nthreads, 1);
-    for (int i = 0; i < nthreads; i++) {
-        pthread_mutex_init(&thread_stats[i].mutex, NULL);
+    if (posix_memalign((void **)&thread_stats, THREAD_STATS_ALIGN,
+                       sizeof(struct thread_stats) * nthreads) != 0) {
+        return NULL;
     }
+    memset(thread_stats, 0, sizeof(struct thread_stats) * nthreads);
     return thread_stats;
 }
 
 void threadlocal_stats_destroy(void *stats)
 {
-    struct thread_stats *thread_stats = stats;
-    for (int i = 0; i < nthreads; i++) {
-        pthread_mutex_destroy(&thread_stats[i].mutex);
-    }
-    free(thread_stats);
+    free(stats);
 }
 
 void threadlocal_stats_reset(struct thread_stats *thread_stats)
 {
     int ii;
     for (ii = 0; ii < settings.num_threads; ++ii) {
-        pthread_mutex_lock(&thread_stats[ii].mutex);
         threadlocal_stats_clear(&thread_stats[ii]);
-        pthread_mutex_unlock(&thread_stats[ii].mutex);
     }
 }
 
@@ -825,142 +820,139 @@ void threadlocal_stats_aggregate(struct thread_stats *thread_stats, struct threa
 {
     int ii;
     for (ii = 0; ii < settings.num_threads; ++ii) {
-        pthread_mutex_lock(&thread_stats[ii].mutex);
-        stats->cmd_get += thread_stats[ii].cmd_get;
-        stats->cmd_set += thread_stats[ii].cmd_set;
-        stats->cmd_incr += thread_stats[ii].cmd_incr;
-        stats->cmd_decr += thread_stats[ii].cmd_decr;
-        stats->cmd_delete += thread_stats[ii].cmd_delete;
-        stats->get_hits += thread_stats[ii].get_hits;
-        stats->get_misses += thread_stats[ii].get_misses;
-        stats->incr_hits += thread_stats[ii].incr_hits;
-        stats->incr_misses += thread_stats[ii].incr_misses;
-        stats->decr_hits += thread_stats[ii].decr_hits;
-        stats->decr_misses += thread_stats[ii].decr_misses;
-        stats->delete_hits += thread_stats[ii].delete_hits;
-        stats->delete_misses += thread_stats[ii].delete_misses;
-        stats->cmd_cas += thread_stats[ii].cmd_cas;
-        stats->cas_hits += thread_stats[ii].cas_hits;
-        stats->cas_badval += thread_stats[ii].cas_badval;
-        stats->cas_misses += thread_stats[ii].cas_misses;
-        stats->cmd_flush += thread_stats[ii].cmd_flush;
-        stats->cmd_flush_prefix += thread_stats[ii].cmd_flush_prefix;
-        stats->cmd_auth += thread_stats[ii].cmd_auth;
-        stats->auth_errors += thread_stats[ii].auth_errors;
-        stats->bytes_read += thread_stats[ii].bytes_read;
-        stats->bytes_written += thread_stats[ii].bytes_written;
-        stats->conn_yields += thread_stats[ii].conn_yields;
+        stats->cmd_get += THREAD_STATS_LOAD(thread_stats[ii].cmd_get);
+        stats->cmd_set += THREAD_STATS_LOAD(thread_stats[ii].cmd_set);
+        stats->cmd_incr += THREAD_STATS_LOAD(thread_stats[ii].cmd_incr);
+        stats->cmd_decr += THREAD_STATS_LOAD(thread_stats[ii].cmd_decr);
+        stats->cmd_delete += THREAD_STATS_LOAD(thread_stats[ii].cmd_delete);
+        stats->get_hits += THREAD_STATS_LOAD(thread_stats[ii].get_hits);
+        stats->get_misses += THREAD_STATS_LOAD(thread_stats[ii].get_misses);
+        stats->incr_hits += THREAD_STATS_LOAD(thread_stats[ii].incr_hits);
+        stats->incr_misses += THREAD_STATS_LOAD(thread_stats[ii].incr_misses);
+        stats->decr_hits += THREAD_STATS_LOAD(thread_stats[ii].decr_hits);
+        stats->decr_misses += THREAD_STATS_LOAD(thread_stats[ii].decr_misses);
+        stats->delete_hits += THREAD_STATS_LOAD(thread_stats[ii].delete_hits);
+        stats->delete_misses += THREAD_STATS_LOAD(thread_stats[ii].delete_misses);
+        stats->cmd_cas += THREAD_STATS_LOAD(thread_stats[ii].cmd_cas);
+        stats->cas_hits += THREAD_STATS_LOAD(thread_stats[ii].cas_hits);
+        stats->cas_badval += THREAD_STATS_LOAD(thread_stats[ii].cas_badval);
+        stats->cas_misses += THREAD_STATS_LOAD(thread_stats[ii].cas_misses);
+        stats->cmd_flush += THREAD_STATS_LOAD(thread_stats[ii].cmd_flush);
+        stats->cmd_flush_prefix += THREAD_STATS_LOAD(thread_stats[ii].cmd_flush_prefix);
+        stats->cmd_auth += THREAD_STATS_LOAD(thread_stats[ii].cmd_auth);
+        stats->auth_errors += THREAD_STATS_LOAD(thread_stats[ii].auth_errors);
+        stats->bytes_read += THREAD_STATS_LOAD(thread_stats[ii].bytes_read);
+        stats->bytes_written += THREAD_STATS_LOAD(thread_stats[ii].bytes_written);
+        stats->conn_yields += THREAD_STATS_LOAD(thread_stats[ii].conn_yields);
         /* list command stats */
-        stats->cmd_lop_create += thread_stats[ii].cmd_lop_create;
-        stats->cmd_lop_insert += thread_stats[ii].cmd_lop_insert;
-        stats->cmd_lop_delete += thread_stats[ii].cmd_lop_delete;
-        stats->cmd_lop_get += thread_stats[ii].cmd_lop_get;
-        stats->lop_create_oks += thread_stats[ii].lop_create_oks;
-        stats->lop_insert_hits += thread_stats[ii].lop_insert_hits;
-        stats->lop_insert_misses += thread_stats[ii].lop_insert_misses;
-        stats->lop_delete_elem_hits += thread_stats[ii].lop_delete_elem_hits;
-        stats->lop_delete_none_hits += thread_stats[ii].lop_delete_none_hits;
-        stats->lop_delete_misses += thread_stats[ii].lop_delete_misses;
-        stats->lop_get_elem_hits += thread_stats[ii].lop_get_elem_hits;
-        stats->lop_get_none_hits += thread_stats[ii].lop_get_none_hits;
-        stats->lop_get_misses += thread_stats[ii].lop_get_misses;
+        stats->cmd_lop_create += THREAD_STATS_LOAD(thread_stats[ii].cmd_lop_create);
+        stats->cmd_lop_insert += THREAD_STATS_LOAD(thread_stats[ii].cmd_lop_insert);
+        stats->cmd_lop_delete += THREAD_STATS_LOAD(thread_stats[ii].cmd_lop_delete);
+        stats->cmd_lop_get += THREAD_STATS_LOAD(thread_stats[ii].cmd_lop_get);
+        stats->lop_create_oks += THREAD_STATS_LOAD(thread_stats[ii].lop_create_oks);
+        stats->lop_insert_hits += THREAD_STATS_LOAD(thread_stats[ii].lop_insert_hits);
+        stats->lop_insert_misses += THREAD_STATS_LOAD(thread_stats[ii].lop_insert_misses);
+        stats->lop_delete_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].lop_delete_elem_hits);
+        stats->lop_delete_none_hits += THREAD_STATS_LOAD(thread_stats[ii].lop_delete_none_hits);
+        stats->lop_delete_misses += THREAD_STATS_LOAD(thread_stats[ii].lop_delete_misses);
+        stats->lop_get_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].lop_get_elem_hits);
+        stats->lop_get_none_hits += THREAD_STATS_LOAD(thread_stats[ii].lop_get_none_hits);
+        stats->lop_get_misses += THREAD_STATS_LOAD(thread_stats[ii].lop_get_misses);
         /* set command stats */
-        stats->cmd_sop_create += thread_stats[ii].cmd_sop_create;
-        stats->cmd_sop_insert += thread_stats[ii].cmd_sop_insert;
-        stats->cmd_sop_delete += thread_stats[ii].cmd_sop_delete;
-        stats->cmd_sop_get += thread_stats[ii].cmd_sop_get;
-        stats->cmd_sop_exist += thread_stats[ii].cmd_sop_exist;
-        stats->sop_create_oks += thread_stats[ii].sop_create_oks;
-        stats->sop_insert_hits += thread_stats[ii].sop_insert_hits;
-        stats->sop_insert_misses += thread_stats[ii].sop_insert_misses;
-        stats->sop_delete_elem_hits += thread_stats[ii].sop_delete_elem_hits;
-        stats->sop_delete_none_hits += thread_stats[ii].sop_delete_none_hits;
-        stats->sop_delete_misses += thread_stats[ii].sop_delete_misses;
-        stats->sop_get_elem_hits += thread_stats[ii].sop_get_elem_hits;
-        stats->sop_get_none_hits += thread_stats[ii].sop_get_none_hits;
-        stats->sop_get_misses += thread_stats[ii].sop_get_misses;
-        stats->sop_exist_hits += thread_stats[ii].sop_exist_hits;
-        stats->sop_exist_misses += thread_stats[ii].sop_exist_misses;
+        stats->cmd_sop_create += THREAD_STATS_LOAD(thread_stats[ii].cmd_sop_create);
+        stats->cmd_sop_insert += THREAD_STATS_LOAD(thread_stats[ii].cmd_sop_insert);
+        stats->cmd_sop_delete += THREAD_STATS_LOAD(thread_stats[ii].cmd_sop_delete);
+        stats->cmd_sop_get += THREAD_STATS_LOAD(thread_stats[ii].cmd_sop_get);
+        stats->cmd_sop_exist += THREAD_STATS_LOAD(thread_stats[ii].cmd_sop_exist);
+        stats->sop_create_oks += THREAD_STATS_LOAD(thread_stats[ii].sop_create_oks);
+        stats->sop_insert_hits += THREAD_STATS_LOAD(thread_stats[ii].sop_insert_hits);
+        stats->sop_insert_misses += THREAD_STATS_LOAD(thread_stats[ii].sop_insert_misses);
+        stats->sop_delete_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].sop_delete_elem_hits);
+        stats->sop_delete_none_hits += THREAD_STATS_LOAD(thread_stats[ii].sop_delete_none_hits);
+        stats->sop_delete_misses += THREAD_STATS_LOAD(thread_stats[ii].sop_delete_misses);
+        stats->sop_get_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].sop_get_elem_hits);
+        stats->sop_get_none_hits += THREAD_STATS_LOAD(thread_stats[ii].sop_get_none_hits);
+        stats->sop_get_misses += THREAD_STATS_LOAD(thread_stats[ii].sop_get_misses);
+        stats->sop_exist_hits += THREAD_STATS_LOAD(thread_stats[ii].sop_exist_hits);
+        stats->sop_exist_misses += THREAD_STATS_LOAD(thread_stats[ii].sop_exist_misses);
         /* map command stats */
-        stats->cmd_mop_create += thread_stats[ii].cmd_mop_create;
-        stats->cmd_mop_insert += thread_stats[ii].cmd_mop_insert;
-        stats->cmd_mop_update += thread_stats[ii].cmd_mop_update;
-        stats->cmd_mop_delete += thread_stats[ii].cmd_mop_delete;
-        stats->cmd_mop_get += thread_stats[ii].cmd_mop_get;
-        stats->mop_create_oks += thread_stats[ii].mop_create_oks;
-        stats->mop_insert_hits += thread_stats[ii].mop_insert_hits;
-        stats->mop_insert_misses += thread_stats[ii].mop_insert_misses;
-        stats->mop_update_elem_hits += thread_stats[ii].mop_update_elem_hits;
-        stats->mop_update_none_hits += thread_stats[ii].mop_update_none_hits;
-        stats->mop_update_misses += thread_stats[ii].mop_update_misses;
-        stats->mop_delete_elem_hits += thread_stats[ii].mop_delete_elem_hits;
-        stats->mop_delete_none_hits += thread_stats[ii].mop_delete_none_hits;
-        stats->mop_delete_misses += thread_stats[ii].mop_delete_misses;
-        stats->mop_get_elem_hits += thread_stats[ii].mop_get_elem_hits;
-        stats->mop_get_none_hits += thread_stats[ii].mop_get_none_hits;
-        stats->mop_get_misses += thread_stats[ii].mop_get_misses;
+        stats->cmd_mop_create += THREAD_STATS_LOAD(thread_stats[ii].cmd_mop_create);
+        stats->cmd_mop_insert += THREAD_STATS_LOAD(thread_stats[ii].cmd_mop_insert);
+        stats->cmd_mop_update += THREAD_STATS_LOAD(thread_stats[ii].cmd_mop_update);
+        stats->cmd_mop_delete += THREAD_STATS_LOAD(thread_stats[ii].cmd_mop_delete);
+        stats->cmd_mop_get += THREAD_STATS_LOAD(thread_stats[ii].cmd_mop_get);
+        stats->mop_create_oks += THREAD_STATS_LOAD(thread_stats[ii].mop_create_oks);
+        stats->mop_insert_hits += THREAD_STATS_LOAD(thread_stats[ii].mop_insert_hits);
+        stats->mop_insert_misses += THREAD_STATS_LOAD(thread_stats[ii].mop_insert_misses);
+        stats->mop_update_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].mop_update_elem_hits);
+        stats->mop_update_none_hits += THREAD_STATS_LOAD(thread_stats[ii].mop_update_none_hits);
+        stats->mop_update_misses += THREAD_STATS_LOAD(thread_stats[ii].mop_update_misses);
+        stats->mop_delete_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].mop_delete_elem_hits);
+        stats->mop_delete_none_hits += THREAD_STATS_LOAD(thread_stats[ii].mop_delete_none_hits);
+        stats->mop_delete_misses += THREAD_STATS_LOAD(thread_stats[ii].mop_delete_misses);
+        stats->mop_get_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].mop_get_elem_hits);
+        stats->mop_get_none_hits += THREAD_STATS_LOAD(thread_stats[ii].mop_get_none_hits);
+        stats->mop_get_misses += THREAD_STATS_LOAD(thread_stats[ii].mop_get_misses);
         /* btree command stats */
-        stats->cmd_bop_create += thread_stats[ii].cmd_bop_create;
-        stats->cmd_bop_insert += thread_stats[ii].cmd_bop_insert;
-        stats->cmd_bop_update += thread_stats[ii].cmd_bop_update;
-        stats->cmd_bop_delete += thread_stats[ii].cmd_bop_delete;
-        stats->cmd_bop_get += thread_stats[ii].cmd_bop_get;
-        stats->cmd_bop_count += thread_stats[ii].cmd_bop_count;
-        stats->cmd_bop_position += thread_stats[ii].cmd_bop_position;
-        stats->cmd_bop_pwg += thread_stats[ii].cmd_bop_pwg;
-        stats->cmd_bop_gbp += thread_stats[ii].cmd_bop_gbp;
+        stats->cmd_bop_create += THREAD_STATS_LOAD(thread_stats[ii].cmd_bop_create);
+        stats->cmd_bop_insert += THREAD_STATS_LOAD(thread_stats[ii].cmd_bop_insert);
+        stats->cmd_bop_update += THREAD_STATS_LOAD(thread_stats[ii].cmd_bop_update);
+        stats->cmd_bop_delete += THREAD_STATS_LOAD(thread_stats[ii].cmd_bop_delete);
+        stats->cmd_bop_get += THREAD_STATS_LOAD(thread_stats[ii].cmd_bop_get);
+        stats->cmd_bop_count += THREAD_STATS_LOAD(thread_stats[ii].cmd_bop_count);
+        stats->cmd_bop_position += THREAD_STATS_LOAD(thread_stats[ii].cmd_bop_position);
+        stats->cmd_bop_pwg += THREAD_STATS_LOAD(thread_stats[ii].cmd_bop_pwg);
+        stats->cmd_bop_gbp += THREAD_STATS_LOAD(thread_stats[ii].cmd_bop_gbp);
 #ifdef SUPPORT_BOP_MGET
-        stats->cmd_bop_mget += thread_stats[ii].cmd_bop_mget;
+        stats->cmd_bop_mget += THREAD_STATS_LOAD(thread_stats[ii].cmd_bop_mget);
 #endif
 #ifdef SUPPORT_BOP_SMGET
-        stats->cmd_bop_smget += thread_stats[ii].cmd_bop_smget;
+        stats->cmd_bop_smget += THREAD_STATS_LOAD(thread_stats[ii].cmd_bop_smget);
 #endif
-        stats->cmd_bop_incr += thread_stats[ii].cmd_bop_incr;
-        stats->cmd_bop_decr += thread_stats[ii].cmd_bop_decr;
-        stats->bop_create_oks += thread_stats[ii].bop_create_oks;
-        stats->bop_insert_hits += thread_stats[ii].bop_insert_hits;
-        stats->bop_insert_misses += thread_stats[ii].bop_insert_misses;
-        stats->bop_update_elem_hits += thread_stats[ii].bop_update_elem_hits;
-        stats->bop_update_none_hits += thread_stats[ii].bop_update_none_hits;
-        stats->bop_update_misses += thread_stats[ii].bop_update_misses;
-        stats->bop_delete_elem_hits += thread_stats[ii].bop_delete_elem_hits;
-        stats->bop_delete_none_hits += thread_stats[ii].bop_delete_none_hits;
-        stats->bop_delete_misses += thread_stats[ii].bop_delete_misses;
-        stats->bop_get_elem_hits += thread_stats[ii].bop_get_elem_hits;
-        stats->bop_get_none_hits += thread_stats[ii].bop_get_none_hits;
-        stats->bop_get_misses += thread_stats[ii].bop_get_misses;
-        stats->bop_count_hits += thread_stats[ii].bop_count_hits;
-        stats->bop_count_misses += thread_stats[ii].bop_count_misses;
-        stats->bop_position_elem_hits += thread_stats[ii].bop_position_elem_hits;
-        stats->bop_position_none_hits += thread_stats[ii].bop_position_none_hits;
-        stats->bop_position_misses += thread_stats[ii].bop_position_misses;
-        stats->bop_pwg_elem_hits += thread_stats[ii].bop_pwg_elem_hits;
-        stats->bop_pwg_none_hits += thread_stats[ii].bop_pwg_none_hits;
-        stats->bop_pwg_misses += thread_stats[ii].bop_pwg_misses;
-        stats->bop_gbp_elem_hits += thread_stats[ii].bop_gbp_elem_hits;
-        stats->bop_gbp_none_hits += thread_stats[ii].bop_gbp_none_hits;
-        stats->bop_gbp_misses += thread_stats[ii].bop_gbp_misses;
+        stats->cmd_bop_incr += THREAD_STATS_LOAD(thread_stats[ii].cmd_bop_incr);
+        stats->cmd_bop_decr += THREAD_STATS_LOAD(thread_stats[ii].cmd_bop_decr);
+        stats->bop_create_oks += THREAD_STATS_LOAD(thread_stats[ii].bop_create_oks);
+        stats->bop_insert_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_insert_hits);
+        stats->bop_insert_misses += THREAD_STATS_LOAD(thread_stats[ii].bop_insert_misses);
+        stats->bop_update_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_update_elem_hits);
+        stats->bop_update_none_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_update_none_hits);
+        stats->bop_update_misses += THREAD_STATS_LOAD(thread_stats[ii].bop_update_misses);
+        stats->bop_delete_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_delete_elem_hits);
+        stats->bop_delete_none_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_delete_none_hits);
+        stats->bop_delete_misses += THREAD_STATS_LOAD(thread_stats[ii].bop_delete_misses);
+        stats->bop_get_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_get_elem_hits);
+        stats->bop_get_none_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_get_none_hits);
+        stats->bop_get_misses += THREAD_STATS_LOAD(thread_stats[ii].bop_get_misses);
+        stats->bop_count_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_count_hits);
+        stats->bop_count_misses += THREAD_STATS_LOAD(thread_stats[ii].bop_count_misses);
+        stats->bop_position_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_position_elem_hits);
+        stats->bop_position_none_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_position_none_hits);
+        stats->bop_position_misses += THREAD_STATS_LOAD(thread_stats[ii].bop_position_misses);
+        stats->bop_pwg_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_pwg_elem_hits);
+        stats->bop_pwg_none_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_pwg_none_hits);
+        stats->bop_pwg_misses += THREAD_STATS_LOAD(thread_stats[ii].bop_pwg_misses);
+        stats->bop_gbp_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_gbp_elem_hits);
+        stats->bop_gbp_none_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_gbp_none_hits);
+        stats->bop_gbp_misses += THREAD_STATS_LOAD(thread_stats[ii].bop_gbp_misses);
 #ifdef SUPPORT_BOP_MGET
-        stats->bop_mget_oks += thread_stats[ii].bop_mget_oks;
+        stats->bop_mget_oks += THREAD_STATS_LOAD(thread_stats[ii].bop_mget_oks);
 #endif
 #ifdef SUPPORT_BOP_SMGET
-        stats->bop_smget_oks += thread_stats[ii].bop_smget_oks;
+        stats->bop_smget_oks += THREAD_STATS_LOAD(thread_stats[ii].bop_smget_oks);
 #endif
-        stats->bop_incr_elem_hits += thread_stats[ii].bop_incr_elem_hits;
-        stats->bop_incr_none_hits += thread_stats[ii].bop_incr_none_hits;
-        stats->bop_incr_misses += thread_stats[ii].bop_incr_misses;
-        stats->bop_decr_elem_hits += thread_stats[ii].bop_decr_elem_hits;
-        stats->bop_decr_none_hits += thread_stats[ii].bop_decr_none_hits;
-        stats->bop_decr_misses += thread_stats[ii].bop_decr_misses;
+        stats->bop_incr_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_incr_elem_hits);
+        stats->bop_incr_none_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_incr_none_hits);
+        stats->bop_incr_misses += THREAD_STATS_LOAD(thread_stats[ii].bop_incr_misses);
+        stats->bop_decr_elem_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_decr_elem_hits);
+        stats->bop_decr_none_hits += THREAD_STATS_LOAD(thread_stats[ii].bop_decr_none_hits);
+        stats->bop_decr_misses += THREAD_STATS_LOAD(thread_stats[ii].bop_decr_misses);
         /* attribute command stats */
-        stats->cmd_getattr += thread_stats[ii].cmd_getattr;
-        stats->cmd_setattr += thread_stats[ii].cmd_setattr;
-        stats->getattr_hits += thread_stats[ii].getattr_hits;
-        stats->getattr_misses += thread_stats[ii].getattr_misses;
-        stats->setattr_hits += thread_stats[ii].setattr_hits;
-        stats->setattr_misses += thread_stats[ii].setattr_misses;
-
-        pthread_mutex_unlock(&thread_stats[ii].mutex);
+        stats->cmd_getattr += THREAD_STATS_LOAD(thread_stats[ii].cmd_getattr);
+        stats->cmd_setattr += THREAD_STATS_LOAD(thread_stats[ii].cmd_setattr);
+        stats->getattr_hits += THREAD_STATS_LOAD(thread_stats[ii].getattr_hits);
+        stats->getattr_misses += THREAD_STATS_LOAD(thread_stats[ii].getattr_misses);
+        stats->setattr_hits += THREAD_STATS_LOAD(thread_stats[ii].setattr_hits);
+        stats->setattr_misses += THREAD_STATS_LOAD(thread_stats[ii].setattr_misses);
     }
 }
 
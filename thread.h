@@ -25,9 +25,13 @@
 
 /**
  * Stats stored per-thread.
+ * Each thread only updates its own stats. So, the counters are updated
+ * with relaxed atomic operations instead of a mutex, and the stats of
+ * each thread are kept in separate cache lines to avoid false sharing.
  */
+#define THREAD_STATS_ALIGN 64 /* cache line size */
+
 struct thread_stats {
-    pthread_mutex_t   mutex;
     uint64_t          cmd_get;
     uint64_t          cmd_set;
     uint64_t          cmd_incr;
@@ -161,28 +165,25 @@ struct thread_stats {
     uint64_t          getattr_misses;
     uint64_t          setattr_hits;
     uint64_t          setattr_misses;
-};
+} __attribute__((aligned(THREAD_STATS_ALIGN)));
 
 /*
  * Macros for incrementing thread_stats
  */
+#define THREAD_STATS_LOAD(v)      __atomic_load_n(&(v), __ATOMIC_RELAXED)
+#define THREAD_STATS_STORE(v, n)  __atomic_store_n(&(v), (n), __ATOMIC_RELAXED)
+
 #define THREAD_STATS_INCR_ONE(thread_stats, op) { \
-    pthread_mutex_lock(&thread_stats->mutex); \
-    thread_stats->op++; \
-    pthread_mutex_unlock(&thread_stats->mutex); \
+    THREAD_STATS_STORE(thread_stats->op, THREAD_STATS_LOAD(thread_stats->op) + 1); \
 }
 
 #define THREAD_STATS_INCR_TWO(thread_stats, op1, op2) { \
-    pthread_mutex_lock(&thread_stats->mutex); \
-    thread_stats->op1++; \
-    thread_stats->op2++; \
-    pthread_mutex_unlock(&thread_stats->mutex); \
+    THREAD_STATS_STORE(thread_stats->op1, THREAD_STATS_LOAD(thread_stats->op1) + 1); \
+    THREAD_STATS_STORE(thread_stats->op2, THREAD_STATS_LOAD(thread_stats->op2) + 1); \
 }
 
 #define THREAD_STATS_INCR_AMT(thread_stats, op, amt) { \
-    pthread_mutex_lock(&thread_stats->mutex); \
-    thread_stats->op += (amt); \
-    pthread_mutex_unlock(&thread_stats->mutex); \
+    THREAD_STATS_STORE(thread_stats->op, THREAD_STATS_LOAD(thread_stats->op) + (amt)); \
 }
 
 enum thread_type {